@@ -0,0 +1,156 @@
+/*
+ * bench_dispatch.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Setup callback cost of standard and HID class requests in configured
+ * state, averaged over many calls of the callback. The same program is
+ * built against usb_jiggler.c of IFELSE_REV (if/else chain), TABLE_REV
+ * (request tables) and the work tree, see Makefile. Revision runs append
+ * their column to file given as argument, work tree run reads them back
+ * and prints all columns.
+ *
+ * Only init_usb_jiggler() is used from the library, it is common to all.
+ */
+
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_hid_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define ROUNDS 1000
+#define BATCHES 50
+#define REV_NMB 2
+
+static const struct {
+	const char *nm;
+	uint8_t bm;
+	uint8_t req;
+	uint16_t val;
+	uint16_t idx;
+	uint16_t len;
+	boolean_t valid;
+} reqs[] = {
+	{"get_stat dev", 0x80, USB_GET_STATUS, 0, 0, 2, TRUE},
+	{"get_stat ifc", 0x81, USB_GET_STATUS, 0, 0, 2, TRUE},
+	{"get_stat edp", 0x82, USB_GET_STATUS, 0, 0x81, 2, TRUE},
+	{"clr_feat edp", 0x02, USB_CLEAR_FEATURE, 0, 0x81, 0, TRUE},
+	{"get_desc dev", 0x80, USB_GET_DESCRIPTOR, USB_DEV_DESC << 8, 0, 18, TRUE},
+	{"get_desc conf", 0x80, USB_GET_DESCRIPTOR, USB_CONF_DESC << 8, 0, 255, TRUE},
+	{"get_desc str", 0x80, USB_GET_DESCRIPTOR, USB_STR_DESC << 8 | 2, 0x0409, 255, TRUE},
+	{"get_desc rep", 0x81, USB_GET_DESCRIPTOR, USB_HID_REPORT_DESC << 8, 0, 255, TRUE},
+	{"get_conf", 0x80, USB_GET_CONFIGURATION, 0, 0, 1, TRUE},
+	{"set_conf", 0x00, USB_SET_CONFIGURATION, 1, 0, 0, TRUE},
+	{"get_iface", 0x81, USB_GET_INTERFACE, 0, 0, 1, TRUE},
+	{"reserved", 0x80, 2, 0, 0, 2, FALSE},
+	{"hid_get_rep", 0xA1, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8, 0, 64, TRUE},
+	{"hid_get_idle", 0xA1, USB_HID_GET_IDLE, 0, 0, 1, TRUE},
+	{"hid_set_idle", 0x21, USB_HID_SET_IDLE, 0, 0, 0, TRUE}
+};
+
+#define REQ_NMB (sizeof(reqs) / sizeof(reqs[0]))
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+
+static void configure(void);
+static unsigned int measure(unsigned int i);
+
+/**
+ * configure
+ */
+static void configure(void)
+{
+	sim_bus_reset();
+	sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL);
+	sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL);
+	SIM_CHECK(get_udp_state() == UDP_STATE_CONFIGURED);
+}
+
+/**
+ * measure
+ *
+ * Returns setup callback cycles of request i, best of BATCHES averages.
+ */
+static unsigned int measure(unsigned int i)
+{
+	uint64_t c, min = UINT64_MAX;
+	int b;
+
+	// Full transfer first, request must be valid in this state.
+	sim_ctl(reqs[i].bm, reqs[i].req, reqs[i].val, reqs[i].idx, reqs[i].len,
+		(reqs[i].bm & 0x80) ? NULL : buf, (reqs[i].bm & 0x80) ? buf : NULL);
+	SIM_CHECK(sim_last.ucr.valid == reqs[i].valid);
+	for (b = 0; b < BATCHES; b++) {
+		c = sim_stp_cycles(reqs[i].bm, reqs[i].req, reqs[i].val, reqs[i].idx, reqs[i].len,
+				   ROUNDS);
+		if (c < min) {
+			min = c;
+		}
+	}
+	return ((min * 10 + ROUNDS / 2) / ROUNDS);
+}
+
+/**
+ * main
+ */
+int main(int argc, char **argv)
+{
+	unsigned int i, cyc[REQ_NMB], sum = 0;
+#ifndef BENCH_REV
+	unsigned int rev[REV_NMB][REQ_NMB] = {{0}}, rev_sum[REV_NMB] = {0}, r;
+#endif
+	FILE *f;
+
+	init_usb_jiggler();
+	configure();
+	for (i = 0; i < REQ_NMB; i++) {
+		cyc[i] = measure(i);
+		sum += cyc[i];
+	}
+#ifdef BENCH_REV
+	if (argc > 1 && (f = fopen(argv[1], "a"))) {
+		for (i = 0; i < REQ_NMB; i++) {
+			fprintf(f, "%u\n", cyc[i]);
+		}
+		fclose(f);
+	}
+	return (sim_result("bench_dispatch_rev"));
+#else
+	if (argc > 1 && (f = fopen(argv[1], "r"))) {
+		for (r = 0; r < REV_NMB; r++) {
+			for (i = 0; i < REQ_NMB && fscanf(f, "%u", &rev[r][i]) == 1; i++) {
+				rev_sum[r] += rev[r][i];
+			}
+			SIM_CHECK(i == REQ_NMB);
+		}
+		fclose(f);
+	}
+	printf("bench_dispatch: setup callback cycles x10, best of %d x %d calls\n", BATCHES, ROUNDS);
+	printf("  %-16s %8s %8s %8s\n", "request", "if/else", "table", "current");
+	for (i = 0; i < REQ_NMB; i++) {
+		printf("  %-16s %8u %8u %8u\n", reqs[i].nm, rev[0][i], rev[1][i], cyc[i]);
+	}
+	printf("  %-16s %8u %8u %8u\n", "total", rev_sum[0], rev_sum[1], sum);
+	return (sim_result("bench_dispatch"));
+#endif
+}
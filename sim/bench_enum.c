@@ -0,0 +1,158 @@
+/*
+ * bench_enum.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Enumeration transfer count and bus time with USB_JIG_DEV_QUAL_DESC 1
+ * (bench_enum) and 0 (bench_enum_stall, see Makefile).
+ *
+ * Host model: Windows like sequence which asks for device qualifier after
+ * the configuration descriptor (other speed configuration is not read from
+ * full-speed device). Stalled request is retried host_retries times, every
+ * transfer takes one frame. Retry count is not measured host behaviour (host
+ * stacks differ), enumeration is run for 0 to HOST_RETRIES_MAX retries and
+ * transfer saving of answered device qualifier depends on it. Other speed
+ * configuration is checked after the measurement.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define HOST_RETRIES_MAX 3
+#define RCP_DEV 0
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+static int host_retries;
+
+static void bus_reset(void);
+static int get_desc(uint8_t type, uint8_t idx, uint16_t w_index, uint16_t len);
+static void enumerate(void);
+#if USB_JIG_DEV_QUAL_DESC == 1
+static void check_alt_speed_conf(void);
+#endif
+
+/**
+ * bus_reset
+ */
+static void bus_reset(void)
+{
+	QueueSetMemberHandle_t m;
+	enum udp_state st;
+
+	sim_bus_reset();
+	// Control task side, state events are consumed.
+	while ((m = xQueueSelectFromSet(jig_ctl_qset, 0))) {
+		xQueueReceive(m, &st, 0);
+	}
+}
+
+/**
+ * get_desc
+ */
+static int get_desc(uint8_t type, uint8_t idx, uint16_t w_index, uint16_t len)
+{
+	int i, n;
+
+	for (i = 0; i <= host_retries; i++) {
+		if ((n = sim_get_desc(RCP_DEV, type, idx, w_index, len, buf)) >= 0) {
+			return (n);
+		}
+	}
+	return (-1);
+}
+
+/**
+ * enumerate
+ */
+static void enumerate(void)
+{
+	struct usb_conf_desc cd;
+
+	bus_reset();
+	get_desc(USB_DEV_DESC, 0, 0, 64);
+	bus_reset();
+	sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL);
+	SIM_CHECK(get_desc(USB_DEV_DESC, 0, 0, 18) == 18);
+	SIM_CHECK(get_desc(USB_CONF_DESC, 0, 0, 255) > 0);
+	if (get_desc(USB_DEV_QUAL_DESC, 0, 0, 10) == 10) {
+		SIM_CHECK(buf[1] == USB_DEV_QUAL_DESC && buf[8] == 1);
+	} else {
+		SIM_CHECK(USB_JIG_DEV_QUAL_DESC == 0);
+	}
+	get_desc(USB_STR_DESC, 0, 0, 255);
+	get_desc(USB_STR_DESC, 2, 0x0409, 255);
+	get_desc(USB_STR_DESC, 3, 0x0409, 255);
+	SIM_CHECK(get_desc(USB_CONF_DESC, 0, 0, 9) == 9);
+	memcpy(&cd, buf, sizeof(cd));
+	SIM_CHECK(get_desc(USB_CONF_DESC, 0, 0, cd.w_total_size) == cd.w_total_size);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(get_udp_state() == UDP_STATE_CONFIGURED);
+}
+
+#if USB_JIG_DEV_QUAL_DESC == 1
+/**
+ * check_alt_speed_conf
+ */
+static void check_alt_speed_conf(void)
+{
+	struct usb_conf_desc cd;
+	const uint8_t *p;
+	int n, eps = 0;
+
+	SIM_CHECK(get_desc(USB_ALT_SPEED_CONF_DESC, 0, 0, 9) == 9);
+	memcpy(&cd, buf, sizeof(cd));
+	n = get_desc(USB_ALT_SPEED_CONF_DESC, 0, 0, cd.w_total_size);
+	SIM_CHECK(n == cd.w_total_size && buf[1] == USB_ALT_SPEED_CONF_DESC);
+	for (p = buf; p < buf + n && p[0]; p += p[0]) {
+		if (p[1] == USB_ENDP_DESC) {
+			// 10 ms polling -> 8 ms, 2^(7 - 1) microframes.
+			SIM_CHECK(p[6] == 7);
+			eps++;
+		}
+	}
+	SIM_CHECK(eps == USB_JIG_KEYB_IFACE + 1);
+}
+#endif
+
+/**
+ * main
+ */
+int main(void)
+{
+	init_usb_jiggler();
+	for (host_retries = 0; host_retries <= HOST_RETRIES_MAX; host_retries++) {
+		sim_reset_ctl_stats();
+		enumerate();
+		printf("bench_enum: dev_qual %s, %d host retries (assumed): %u transfers, %u stalls, "
+		       "%u packets, %u us bus time\n", USB_JIG_DEV_QUAL_DESC == 1 ? "answered" : "stalled",
+		       host_retries, sim_ctl_stats.xfers, sim_ctl_stats.stalls, sim_ctl_stats.pkts,
+		       (unsigned int) sim_ctl_stats.bus_us);
+	}
+#if USB_JIG_DEV_QUAL_DESC == 1
+	check_alt_speed_conf();
+#endif
+	return (sim_result(USB_JIG_DEV_QUAL_DESC == 1 ? "bench_enum" : "bench_enum_stall"));
+}
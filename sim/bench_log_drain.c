@@ -0,0 +1,166 @@
+/*
+ * bench_log_drain.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Log drain modes, built with USB_LOG_DRAIN_TASK (bench_log_drain_task),
+ * USB_LOG_DRAIN_IDLE (bench_log_drain) and USB_LOG_DRAIN_TMR
+ * (bench_log_drain_tmr), setup and command events stamped
+ * (USB_JIG_LOG_TS). Prints:
+ *   - RAM of the drain path for 32-bit target: task stack and TCB
+ *     (TGT_TCB), timer control block (TGT_TMR_CB) and pending flag, idle
+ *     mode needs none. Event queue is common to all modes.
+ *   - latency in ticks from event capture to formatting (q field of log
+ *     line) for BURSTS enumeration like bursts of BURST_XFERS transfers,
+ *     each followed by GAP_TICKS quiet ticks. Application keeps CPU busy
+ *     BUSY_TICKS of every LOAD_PER ticks, idle hook runs in the other ticks.
+ *     USBLOG task preempts the application at higher priority, it is run
+ *     (sim_run_tasks()) after every transfer and tick.
+ * Every mode checks that all events are formatted or counted as lost, idle
+ * hook and timer callbacks run with sim_no_block set (blocking call aborts).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_log.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define BURSTS 20
+#define BURST_XFERS 12
+#define GAP_TICKS 40
+#define LOAD_PER 10
+#define BUSY_TICKS 8
+#define TGT_TCB 96
+#define TGT_TMR_CB 44
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+static unsigned int lines, q_sum, q_max;
+
+static void idle(void);
+static void burst(void);
+static void collect(void);
+
+/**
+ * idle
+ *
+ * After transfer or tick, USBLOG task runs at once, idle hook if
+ * application is not busy.
+ */
+static void idle(void)
+{
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
+	sim_run_tasks();
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_IDLE
+	if (xTaskGetTickCount() % LOAD_PER >= BUSY_TICKS) {
+		sim_no_block++;
+		run_usb_log_drain();
+		sim_no_block--;
+	}
+#endif
+}
+
+/**
+ * burst
+ */
+static void burst(void)
+{
+	int i;
+
+	for (i = 0; i < BURST_XFERS; i++) {
+		SIM_CHECK(sim_get_desc(0, USB_DEV_DESC, 0, 0, 18, buf) == 18);
+		idle();
+	}
+	for (i = 0; i < GAP_TICKS; i++) {
+		sim_advance(1);
+		idle();
+	}
+}
+
+/**
+ * collect
+ *
+ * Reads q fields of formatted log lines.
+ */
+static void collect(void)
+{
+	const char *p;
+	unsigned int q;
+
+	for (p = sim_msg_text(); (p = strstr(p, " q")); p += 2) {
+		q = strtoul(p + 2, NULL, 10);
+		lines++;
+		q_sum += q;
+		if (q > q_max) {
+			q_max = q;
+		}
+	}
+	sim_msg_clear();
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	const char *mode, *p;
+	unsigned int ram, lost = 0;
+	int i;
+
+	init_usb_jiggler();
+	sim_bus_reset();
+	SIM_CHECK(sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	// Setup events out of the measurement.
+	for (i = 0; i < GAP_TICKS; i++) {
+		sim_advance(1);
+		idle();
+	}
+	sim_msg_clear();
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
+	mode = "task";
+	ram = USB_LOG_EVENTS_TASK_STACK_SIZE * sizeof(uint32_t) + TGT_TCB;
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_IDLE
+	mode = "idle";
+	ram = 0;
+#else
+	mode = "tmr";
+	ram = TGT_TMR_CB + sizeof(uint32_t);
+#endif
+	for (i = 0; i < BURSTS; i++) {
+		burst();
+		collect();
+	}
+	log_usb_log_stats();
+	if ((p = strstr(sim_msg_text(), "log_usb_que_full="))) {
+		lost = strtoul(p + strlen("log_usb_que_full="), NULL, 10);
+	}
+	SIM_CHECK(lines + lost == BURSTS * (BURST_XFERS * 2));
+	printf("bench_log_drain: %s: %u bytes RAM, latency avg %.1f max %u ticks, %u of %u events lost\n",
+	       mode, ram, (lines) ? (double) q_sum / lines : 0.0, q_max, lost, lines + lost);
+	return (sim_result((USB_LOG_DRAIN == USB_LOG_DRAIN_TASK) ? "bench_log_drain_task" :
+			   (USB_LOG_DRAIN == USB_LOG_DRAIN_IDLE) ? "bench_log_drain" :
+			   "bench_log_drain_tmr"));
+}
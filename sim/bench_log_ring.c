@@ -0,0 +1,123 @@
+/*
+ * bench_log_ring.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Library event capture by log ring (USB_LOG_RING 1, bench_log_ring) and by
+ * logger queue (USB_LOG_RING 0, bench_log_ring_que), USBLOG task drain,
+ * UDP driver state events logged. Prints:
+ *   - RAM of logger queue and ring, host sizes of events (64-bit pointers).
+ *   - setup callback cycles per transfer (interrupt time) with setup event
+ *     captured, CHUNK transfers between log task runs.
+ * Checks that log task formats UDP driver and library events as soon as it
+ * runs (no tick passes), that it formats nothing when idle and that no
+ * event is lost.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_log.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define ROUNDS 20000
+#define CHUNK 4
+#define IDLE_TICKS 100
+
+static void bus_reset(void);
+static unsigned int count_lines(void);
+
+/**
+ * bus_reset
+ */
+static void bus_reset(void)
+{
+	QueueSetMemberHandle_t m;
+	enum udp_state st;
+
+	sim_bus_reset();
+	// Control task side, state events are consumed.
+	while ((m = xQueueSelectFromSet(jig_ctl_qset, 0))) {
+		xQueueReceive(m, &st, 0);
+	}
+}
+
+/**
+ * count_lines
+ *
+ * Returns number of formatted library log lines, clears them.
+ */
+static unsigned int count_lines(void)
+{
+	const char *p;
+	unsigned int n = 0;
+
+	for (p = sim_msg_text(); (p = strstr(p, "usb_jiggler.c: ")); p++) {
+		n++;
+	}
+	sim_msg_clear();
+	return (n);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	uint64_t cyc = 0;
+	unsigned int ram, lines = 0;
+	int i;
+
+	init_usb_jiggler();
+	sim_run_tasks();
+	sim_msg_clear();
+	bus_reset();
+	sim_run_tasks();
+	SIM_CHECK(strstr(sim_msg_text(), "udp.c: state=") != NULL);
+	sim_msg_clear();
+	SIM_CHECK(sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL) == 0);
+	sim_run_tasks();
+	SIM_CHECK(strstr(sim_msg_text(), "[set_addr]=") != NULL);
+	sim_msg_clear();
+	sim_advance(IDLE_TICKS);
+	sim_run_tasks();
+	SIM_CHECK(sim_msg_text()[0] == '\0');
+	for (i = 0; i < ROUNDS / CHUNK; i++) {
+		cyc += sim_stp_cycles(0x80, USB_GET_DESCRIPTOR, USB_DEV_DESC << 8, 0, 18, CHUNK);
+		sim_run_tasks();
+		lines += count_lines();
+	}
+	// Setup event per transfer, command event comes with data stage.
+	SIM_CHECK(lines == ROUNDS);
+	log_usb_log_stats();
+	SIM_CHECK(sim_msg_text()[0] == '\0');
+	ram = sim_logger_que_bytes();
+#if USB_LOG_RING == 1
+	ram += USB_LOG_RING_SIZE;
+#endif
+	printf("bench_log_ring: %s: %u bytes RAM (queue %u), %.0f cycles per setup\n",
+	       (USB_LOG_RING == 1) ? "ring" : "queue", ram, (unsigned int) sim_logger_que_bytes(),
+	       (double) cyc / ROUNDS);
+	return (sim_result((USB_LOG_RING == 1) ? "bench_log_ring" : "bench_log_ring_que"));
+}
@@ -0,0 +1,150 @@
+/*
+ * bench_pattern.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Pattern step cost: cycles per get_mouse_pattern_report() of every
+ * pattern type (best of BATCHES averages) checked against
+ * MOUSE_PATTERN_STEP_CYCLES. Host core runs the integer step code in no
+ * more cycles than the target, so the check is an upper bound guard, the
+ * numbers are not target cycles.
+ *
+ * Circle must return to its start after one period and Lissajous period 1
+ * must move (clamped to 2).
+ */
+
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_pattern.h"
+#include "sim.h"
+
+#define STEPS 1000
+#define BATCHES 200
+
+static const int16_t bez_pts[3][2] = {{40, -80}, {160, 90}, {200, 0}};
+
+static void init_pattern(struct mouse_pattern *mp, enum mouse_pattern_type type);
+static unsigned int measure(enum mouse_pattern_type type);
+static void check_circle(void);
+static void check_short_period(void);
+
+/**
+ * init_pattern
+ */
+static void init_pattern(struct mouse_pattern *mp, enum mouse_pattern_type type)
+{
+	switch (type) {
+	case MOUSE_PATTERN_LISSAJOUS :
+		init_mouse_pattern_lissajous(mp, 60, 40, 300, 200, 0x1000, 0);
+		break;
+	case MOUSE_PATTERN_RANDOM_WALK :
+		init_mouse_pattern_random_walk(mp, 20, 1234, 0);
+		break;
+	case MOUSE_PATTERN_BEZIER :
+		// Endless Bezier is not possible, steps cover one batch.
+		init_mouse_pattern_bezier(mp, bez_pts, STEPS);
+		break;
+	}
+}
+
+/**
+ * measure
+ *
+ * Returns cycles per step x10.
+ */
+static unsigned int measure(enum mouse_pattern_type type)
+{
+	struct mouse_pattern mp;
+	struct mouse_report rep = {0};
+	uint64_t t, min = UINT64_MAX;
+	int b, i;
+
+	for (b = 0; b < BATCHES; b++) {
+		init_pattern(&mp, type);
+		t = sim_cycles();
+		for (i = 0; i < STEPS; i++) {
+			get_mouse_pattern_report(&mp, &rep);
+		}
+		t = sim_cycles() - t;
+		if (t < min) {
+			min = t;
+		}
+	}
+	return ((min * 10 + STEPS / 2) / STEPS);
+}
+
+/**
+ * check_circle
+ */
+static void check_circle(void)
+{
+	struct mouse_pattern mp;
+	struct mouse_report rep = {0};
+	int i, x = 0, y = 0;
+
+	init_mouse_pattern_circle(&mp, 50, 100, 100);
+	for (i = 0; get_mouse_pattern_report(&mp, &rep); i++) {
+		x += rep.x;
+		y += rep.y;
+	}
+	SIM_CHECK(i == 100);
+	SIM_CHECK(x >= -1 && x <= 1 && y >= -1 && y <= 1);
+}
+
+/**
+ * check_short_period
+ */
+static void check_short_period(void)
+{
+	struct mouse_pattern mp;
+	struct mouse_report rep = {0};
+	int i, moves = 0;
+
+	init_mouse_pattern_lissajous(&mp, 10, 10, 1, 1, 0x4000, 10);
+	for (i = 0; get_mouse_pattern_report(&mp, &rep); i++) {
+		if (rep.x) {
+			moves++;
+		}
+	}
+	SIM_CHECK(moves == 10);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	static const char *nms[] = {"lissajous", "random walk", "bezier"};
+	unsigned int c;
+	int i;
+
+	check_circle();
+	check_short_period();
+	for (i = MOUSE_PATTERN_LISSAJOUS; i <= MOUSE_PATTERN_BEZIER; i++) {
+		c = measure(i);
+		SIM_CHECK(c <= MOUSE_PATTERN_STEP_CYCLES * 10);
+		printf("bench_pattern: %s %u.%u cycles/step (budget %d)\n", nms[i], c / 10, c % 10,
+		       MOUSE_PATTERN_STEP_CYCLES);
+	}
+	return (sim_result("bench_pattern"));
+}
@@ -0,0 +1,183 @@
+/*
+ * bench_trace.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Trace playback: encoded size in bytes per minute of motion and decode
+ * cycles per frame (best of BATCHES averages).
+ *
+ * Trace is synthetic human like motion: pauses, minimum jerk moves of
+ * random length and duration with jitter, clicks and wheel steps. Decoded
+ * frames must equal the encoded ones.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_trace.h"
+#include "trace_enc.h"
+#include "sim.h"
+
+#define MINUTES 10
+#define FRM_NMB (MINUTES * 60000 / USB_JIG_IN_M_ENDP_POLLED_MS)
+#define BATCHES 50
+
+static struct mouse_report frms[FRM_NMB];
+static uint8_t data[5 * FRM_NMB + 1];
+static uint32_t rnd_state = 2026;
+
+static int rnd(int n);
+static int gen_pause(int i, uint8_t bm);
+static int gen_move(int i, uint8_t bm);
+static void gen_trace(void);
+static boolean_t check_decode(void);
+
+/**
+ * rnd
+ */
+static int rnd(int n)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return ((rnd_state >> 8) % n);
+}
+
+/**
+ * gen_pause
+ */
+static int gen_pause(int i, uint8_t bm)
+{
+	int n;
+
+	for (n = 20 + rnd(280); n && i < FRM_NMB; n--, i++) {
+		frms[i].bm = bm;
+		frms[i].x = frms[i].y = frms[i].w = 0;
+	}
+	return (i);
+}
+
+/**
+ * gen_move
+ *
+ * Minimum jerk profile s = 10t^3 - 15t^4 + 6t^5, position in 1/1024 px.
+ */
+static int gen_move(int i, uint8_t bm)
+{
+	int64_t t, s, dur;
+	int32_t dx, dy, px = 0, py = 0, x, y;
+	int k;
+
+	dx = rnd(801) - 400;
+	dy = rnd(501) - 250;
+	dur = 20 + rnd(60);
+	for (k = 1; k <= dur && i < FRM_NMB; k++, i++) {
+		t = k * 1024 / dur;
+		s = (10 * t * t * t * 1024 - 15 * t * t * t * t + 6 * t * t * t * t * t / 1024) >> 30;
+		x = dx * s / 1024 + ((rnd(4)) ? 0 : rnd(3) - 1);
+		y = dy * s / 1024 + ((rnd(4)) ? 0 : rnd(3) - 1);
+		frms[i].bm = bm;
+		frms[i].x = x - px;
+		frms[i].y = y - py;
+		frms[i].w = 0;
+		px = x;
+		py = y;
+	}
+	return (i);
+}
+
+/**
+ * gen_trace
+ */
+static void gen_trace(void)
+{
+	int i = 0, k;
+
+	while (i < FRM_NMB) {
+		i = gen_pause(i, 0);
+		i = gen_move(i, 0);
+		if (!rnd(4)) {
+			// Click.
+			for (k = 8 + rnd(8); k && i < FRM_NMB; k--, i++) {
+				frms[i].bm = 1;
+				frms[i].x = frms[i].y = frms[i].w = 0;
+			}
+		} else if (!rnd(3)) {
+			// Wheel steps.
+			for (k = 1 + rnd(6); k && i < FRM_NMB; k--, i++) {
+				frms[i].bm = 0;
+				frms[i].x = frms[i].y = 0;
+				frms[i].w = (rnd(2)) ? 1 : -1;
+			}
+		}
+	}
+}
+
+/**
+ * check_decode
+ */
+static boolean_t check_decode(void)
+{
+	struct mouse_trace mt;
+	struct mouse_report rep;
+	int i;
+
+	start_mouse_trace(&mt, data, FALSE);
+	for (i = 0; i < FRM_NMB; i++) {
+		if (!get_mouse_trace_report(&mt, &rep) || memcmp(&rep, &frms[i], sizeof(rep))) {
+			return (FALSE);
+		}
+	}
+	return (!get_mouse_trace_report(&mt, &rep));
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	struct mouse_trace mt;
+	struct mouse_report rep;
+	uint64_t t, min = UINT64_MAX;
+	int b, i, len;
+
+	gen_trace();
+	len = encode_mouse_trace(frms, FRM_NMB, data, sizeof(data));
+	SIM_CHECK(len > 0);
+	SIM_CHECK(check_decode());
+	for (b = 0; b < BATCHES; b++) {
+		start_mouse_trace(&mt, data, FALSE);
+		t = sim_cycles();
+		for (i = 0; i < FRM_NMB; i++) {
+			get_mouse_trace_report(&mt, &rep);
+		}
+		t = sim_cycles() - t;
+		if (t < min) {
+			min = t;
+		}
+	}
+	printf("bench_trace: %d frames, %d bytes, %d bytes/min (raw reports %d bytes/min)\n",
+	       FRM_NMB, len, len / MINUTES, (int) (FRM_NMB / MINUTES * sizeof(struct mouse_report)));
+	printf("bench_trace: decode %u.%u cycles/frame, player state %u bytes\n",
+	       (unsigned int) (min * 10 / FRM_NMB / 10), (unsigned int) (min * 10 / FRM_NMB % 10),
+	       (unsigned int) sizeof(struct mouse_trace));
+	return (sim_result("bench_trace"));
+}
@@ -0,0 +1,168 @@
+/*
+ * bench_typing.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Typing speed: text is typed with one report per keyboard endpoint poll
+ * (USB_JIG_IN_K_ENDP_POLLED_MS), characters per second are compared with
+ * one key per report typing (press and release report per character).
+ * Key presses seen by the host (keys new in report) are counted to check
+ * that no character is lost.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "keyb_typing.h"
+#include "sim.h"
+
+#define REPEAT 20
+
+static const char txt_us[] =
+	"The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs! "
+	"Sphinx of black quartz, judge my vow; 0123456789 (a+b)*c = d/e - f. ";
+
+static const char txt_sk[] =
+	"Kŕdeľ šťastných ďatľov učí pri ústí Váhu mĺkveho koňa obhrýzať kôru a žrať čerstvé mäso. ";
+
+static char buf[4096];
+
+static int count_presses(const struct keyb_report *rep, const struct keyb_report *prev);
+static int count_chars(const char *s);
+static int count_strokes(const char *s, const struct keyb_layout *lay);
+static void bench(const char *nm, const char *txt, const struct keyb_layout *lay);
+
+/**
+ * count_presses
+ */
+static int count_presses(const struct keyb_report *rep, const struct keyb_report *prev)
+{
+	int i, j, n = 0;
+
+	for (i = 0; i < KEYB_REPORT_KEY_ARY_SIZE && rep->keys[i]; i++) {
+		for (j = 0; j < KEYB_REPORT_KEY_ARY_SIZE; j++) {
+			if (prev->keys[j] == rep->keys[i]) {
+				break;
+			}
+		}
+		if (j == KEYB_REPORT_KEY_ARY_SIZE) {
+			n++;
+		}
+	}
+	return (n);
+}
+
+/**
+ * count_chars
+ */
+static int count_chars(const char *s)
+{
+	int n = 0;
+
+	for (; *s; s++) {
+		if ((*s & 0xC0) != 0x80) {
+			n++;
+		}
+	}
+	return (n);
+}
+
+/**
+ * count_strokes
+ *
+ * Returns key presses (dead key and key) typing s needs in layout lay.
+ */
+static int count_strokes(const char *s, const struct keyb_layout *lay)
+{
+	const struct keyb_keymap_item *ki;
+	uint16_t cp;
+	int i, n = 0;
+
+	while (*s) {
+		if (!(*s & 0x80)) {
+			cp = *s++;
+		} else {
+			// Two byte sequences only (Latin).
+			cp = (s[0] & 0x1F) << 6 | (s[1] & 0x3F);
+			s += 2;
+		}
+		ki = NULL;
+		if (cp >= 0x20 && cp <= 0x7E) {
+			ki = &lay->ascii[cp - 0x20];
+		} else {
+			for (i = 0; i < lay->ext_nmb; i++) {
+				if (lay->ext[i].cp == cp) {
+					ki = &lay->ext[i].ki;
+					break;
+				}
+			}
+		}
+		if (ki) {
+			n += (ki->dead.key != 0) + (ki->stroke.key != 0);
+		}
+	}
+	return (n);
+}
+
+/**
+ * bench
+ */
+static void bench(const char *nm, const char *txt, const struct keyb_layout *lay)
+{
+	struct keyb_typing kt;
+	struct keyb_report rep, prev;
+	uint64_t t;
+	int i, chars, reps = 0, presses = 0;
+
+	buf[0] = '\0';
+	for (i = 0; i < REPEAT; i++) {
+		strcat(buf, txt);
+	}
+	chars = count_chars(buf);
+	memset(&prev, 0, sizeof(prev));
+	start_keyb_typing(&kt, buf, lay);
+	t = sim_cycles();
+	while (get_keyb_typing_report(&kt, &rep)) {
+		presses += count_presses(&rep, &prev);
+		prev = rep;
+		reps++;
+	}
+	t = sim_cycles() - t;
+	SIM_CHECK(presses == count_strokes(txt, lay) * REPEAT);
+	SIM_CHECK(reps < 2 * chars);
+	printf("bench_typing: %s %d chars in %d reports, %u chars/s (one key per report %u chars/s), "
+	       "%u cycles/report\n", nm, chars, reps,
+	       (unsigned int) (chars * 1000ULL / (reps * USB_JIG_IN_K_ENDP_POLLED_MS)),
+	       (unsigned int) (1000 / (2 * USB_JIG_IN_K_ENDP_POLLED_MS)), (unsigned int) (t / reps));
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	init_usb_jiggler();
+	bench("us", txt_us, &keyb_layout_us);
+	bench("sk", txt_sk, &keyb_layout_sk);
+	return (sim_result("bench_typing"));
+}
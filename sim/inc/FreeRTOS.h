@@ -0,0 +1,60 @@
+/*
+ * FreeRTOS.h
+ *
+ * Host simulation (sim/sim.c) stand-in for FreeRTOS kernel types and port
+ * macros used by the library. One tick is one millisecond.
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+typedef struct sim_que *QueueHandle_t;
+typedef struct sim_que *QueueSetHandle_t;
+typedef struct sim_que *QueueSetMemberHandle_t;
+typedef struct sim_que *SemaphoreHandle_t;
+typedef struct sim_tsk *TaskHandle_t;
+typedef struct sim_tmr *TimerHandle_t;
+
+/*
+ * Static control blocks hold the simulator objects, sizes are not those
+ * of a target build.
+ */
+typedef struct {
+	void *p[8];
+} StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+typedef struct {
+	void *p[12];
+} StaticTask_t;
+typedef struct {
+	void *p[12];
+} StaticTimer_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define configTICK_RATE_HZ 1000
+#define configMINIMAL_STACK_SIZE 128
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+
+void sim_enter_critical(void);
+void sim_exit_critical(void);
+
+#define portYIELD_FROM_ISR(x) ((void) (x))
+#define taskENTER_CRITICAL() sim_enter_critical()
+#define taskEXIT_CRITICAL() sim_exit_critical()
+#define taskENTER_CRITICAL_FROM_ISR() (sim_enter_critical(), 0)
+#define taskEXIT_CRITICAL_FROM_ISR(x) ((void) (x), sim_exit_critical())
+
+#endif
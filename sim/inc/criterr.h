@@ -0,0 +1,15 @@
+/*
+ * criterr.h
+ *
+ * Host simulation stand-in, crit_err_exit() aborts the test.
+ */
+
+#ifndef CRITERR_H
+#define CRITERR_H
+
+#define MALLOC_ERROR 1
+#define BAD_PARAMETER 2
+
+void crit_err_exit(int err) __attribute__ ((noreturn));
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * gentyp.h
+ *
+ * Host simulation stand-in for framework generic types.
+ */
+
+#ifndef GENTYP_H
+#define GENTYP_H
+
+typedef int boolean_t;
+
+#define TRUE 1
+#define FALSE 0
+
+typedef struct {
+	QueueHandle_t que;
+	void (*que_err)(void);
+} logger_t;
+
+struct txt_item {
+	int code;
+	const char *txt;
+};
+
+#endif
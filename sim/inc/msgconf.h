@@ -0,0 +1,17 @@
+/*
+ * msgconf.h
+ *
+ * Host simulation stand-in, msg() output is captured (sim_msg_text()) and
+ * echoed to stdout if sim_msg_echo is set.
+ */
+
+#ifndef MSGCONF_H
+#define MSGCONF_H
+
+#define INF 1
+// msg() copies to buffer, it never blocks.
+#define MSG_NONBLOCK 1
+
+void msg(int lev, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * queue.h
+ *
+ * Host simulation stand-in for FreeRTOS queues and queue sets. Blocking
+ * calls advance simulated time (sim_block_hook runs every tick).
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size, uint8_t *buf,
+				 StaticQueue_t *stc);
+BaseType_t xQueueSend(QueueHandle_t que, const void *item, TickType_t tmo);
+BaseType_t xQueueSendFromISR(QueueHandle_t que, const void *item, BaseType_t *hpw);
+BaseType_t xQueueReceive(QueueHandle_t que, void *item, TickType_t tmo);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t que, void *item, BaseType_t *hpw);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t que);
+QueueSetHandle_t xQueueCreateSet(UBaseType_t len);
+QueueSetHandle_t xQueueCreateSetStatic(UBaseType_t len, uint8_t *buf, StaticQueue_t *stc);
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t mbr, QueueSetHandle_t set);
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t tmo);
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * semphr.h
+ *
+ * Host simulation stand-in for FreeRTOS binary semaphores (queue of one
+ * item of size 0).
+ */
+
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include "queue.h"
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *stc);
+
+#define xSemaphoreGive(sem) xQueueSend((sem), NULL, 0)
+#define xSemaphoreGiveFromISR(sem, hpw) xQueueSendFromISR((sem), NULL, (hpw))
+#define xSemaphoreTake(sem, tmo) xQueueReceive((sem), NULL, (tmo))
+#define uxSemaphoreGetCount(sem) uxQueueMessagesWaiting((sem))
+
+#endif
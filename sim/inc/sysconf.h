@@ -0,0 +1,57 @@
+/*
+ * sysconf.h
+ *
+ * Host simulation application configuration. Every setting may be
+ * overridden per test binary with -D (sim/Makefile).
+ */
+
+#ifndef SYSCONF_H
+#define SYSCONF_H
+
+#ifndef TERMOUT
+#define TERMOUT 1
+#endif
+
+#ifndef USB_JIG_KEYB_IFACE
+#define USB_JIG_KEYB_IFACE 1
+#endif
+#ifndef LOG_KEYB_LEDS
+#define LOG_KEYB_LEDS 1
+#endif
+#define USB_JIG_VENDORID 0x1209
+#define USB_JIG_PRODUCTID 0x0001
+#define USB_JIG_IN_M_ENDP_NUM 1
+#ifndef USB_JIG_IN_M_ENDP_MAX_PKT_SIZE
+#define USB_JIG_IN_M_ENDP_MAX_PKT_SIZE 8
+#endif
+#define USB_JIG_IN_M_ENDP_POLLED_MS 10
+#define USB_JIG_IN_K_ENDP_NUM 2
+#ifndef USB_JIG_IN_K_ENDP_MAX_PKT_SIZE
+#define USB_JIG_IN_K_ENDP_MAX_PKT_SIZE 32
+#endif
+#define USB_JIG_IN_K_ENDP_POLLED_MS 10
+
+#define UDP_EVNT_QUE_SIZE 8
+#define JIGBTN_EVNT_QUE_SIZE 4
+
+#ifndef SIM_LOG
+#define SIM_LOG 0
+#endif
+#define UDP_LOG_INTR_EVENTS 0
+#ifndef UDP_LOG_STATE_EVENTS
+#define UDP_LOG_STATE_EVENTS 0
+#endif
+#define UDP_LOG_ENDP_EVENTS 0
+#define UDP_LOG_OUT_IRP_EVENTS 0
+#define UDP_LOG_ERR_EVENTS 0
+#define USB_LOG_CTL_REQ_EVENTS 0
+#define USB_LOG_CTL_REQ_STP_EVENTS SIM_LOG
+#define USB_LOG_CTL_REQ_CMD_EVENTS SIM_LOG
+#define USB_LOG_EVENTS_QUEUE_SIZE 64
+#define USB_LOG_EVENTS_TASK_STACK_SIZE 256
+#define USB_LOG_EVENTS_TASK_PRIO 1
+#ifndef USB_LOG_DRAIN
+#define USB_LOG_DRAIN 1 // USB_LOG_DRAIN_IDLE, drained by run_usb_log_drain().
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * task.h
+ *
+ * Host simulation stand-in for FreeRTOS task API. Tasks are recorded and
+ * run only by sim_run_tasks(), test code runs as the main task.
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+typedef enum {
+	eNoAction,
+	eSetBits,
+	eIncrement,
+	eSetValueWithOverwrite,
+	eSetValueWithoutOverwrite
+} eNotifyAction;
+
+typedef struct {
+	TickType_t start;
+} TimeOut_t;
+
+BaseType_t xTaskCreate(void (*fn)(void *), const char *nm, uint32_t stack, void *arg,
+		       UBaseType_t prio, TaskHandle_t *hndl);
+TaskHandle_t xTaskCreateStatic(void (*fn)(void *), const char *nm, uint32_t stack, void *arg,
+			       UBaseType_t prio, StackType_t *stk, StaticTask_t *stc);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskSetTimeOutState(TimeOut_t *to);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *to, TickType_t *tmo);
+BaseType_t xTaskNotify(TaskHandle_t tsk, uint32_t val, eNotifyAction act);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t tsk, uint32_t val, eNotifyAction act,
+			      BaseType_t *hpw);
+BaseType_t xTaskNotifyWait(uint32_t clr_entry, uint32_t clr_exit, uint32_t *val, TickType_t tmo);
+void vTaskNotifyGiveFromISR(TaskHandle_t tsk, BaseType_t *hpw);
+uint32_t ulTaskNotifyTake(BaseType_t clr, TickType_t tmo);
+
+#endif
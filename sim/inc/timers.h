@@ -0,0 +1,21 @@
+/*
+ * timers.h
+ *
+ * Host simulation stand-in for FreeRTOS software timers. Timer service
+ * work runs in sim_advance().
+ */
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+TimerHandle_t xTimerCreate(const char *nm, TickType_t per, UBaseType_t reload, void *id,
+			   void (*clbk)(TimerHandle_t));
+TimerHandle_t xTimerCreateStatic(const char *nm, TickType_t per, UBaseType_t reload, void *id,
+				 void (*clbk)(TimerHandle_t), StaticTimer_t *stc);
+BaseType_t xTimerStart(TimerHandle_t tmr, TickType_t tmo);
+BaseType_t xTimerPendFunctionCall(void (*fn)(void *, uint32_t), void *p, uint32_t u,
+				  TickType_t tmo);
+BaseType_t xTimerPendFunctionCallFromISR(void (*fn)(void *, uint32_t), void *p, uint32_t u,
+					 BaseType_t *hpw);
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * tools.h
+ *
+ * Host simulation stand-in.
+ */
+
+#ifndef TOOLS_H
+#define TOOLS_H
+
+const char *find_txt_item(int code, const struct txt_item *ary, const char *dflt);
+
+#endif
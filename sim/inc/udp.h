@@ -0,0 +1,91 @@
+/*
+ * udp.h
+ *
+ * Host simulation stand-in for the USB device port (UDP) driver. Endpoint
+ * and device state are kept by sim/sim.c, event queue items are
+ * enum udp_state values (new state).
+ */
+
+#ifndef UDP_H
+#define UDP_H
+
+#define UDP_EP_NMB 4
+#define UDP_CTL_TRANS_OUT 0
+#define UDP_CTL_TRANS_IN 1
+
+enum udp_state {
+	UDP_STATE_POWERED,
+	UDP_STATE_DEFAULT,
+	UDP_STATE_ADDRESSED,
+	UDP_STATE_CONFIGURED,
+	UDP_STATE_SUSPENDED
+};
+
+enum udp_endp_dir {
+	UDP_ENDP_DIR_OUT,
+	UDP_ENDP_DIR_IN
+};
+
+struct usb_stp_pkt {
+	uint8_t bm_request_type;
+	uint8_t b_request;
+	uint16_t w_value;
+	uint16_t w_index;
+	uint16_t w_length;
+} __attribute__ ((packed));
+
+#define UDP_INTR_EVENT_TYPE 1
+#define UDP_STATE_EVENT_TYPE 2
+#define UDP_ENDP_EVENT_TYPE 3
+#define UDP_OUT_IRP_EVENT_TYPE 4
+#define UDP_ERR_EVENT_TYPE 5
+
+struct udp_intr_event {
+	int8_t type;
+	uint32_t isr;
+	void (*fmt)(struct udp_intr_event *);
+};
+
+struct udp_state_event {
+	int8_t type;
+	uint8_t state;
+	void (*fmt)(struct udp_state_event *);
+};
+
+struct udp_endp_event {
+	int8_t type;
+	uint8_t ep;
+	uint32_t csr;
+	void (*fmt)(struct udp_endp_event *);
+};
+
+struct udp_out_irp_event {
+	int8_t type;
+	uint8_t ep;
+	uint32_t nmb;
+	void (*fmt)(struct udp_out_irp_event *);
+};
+
+struct udp_err_event {
+	int8_t type;
+	uint32_t err;
+	void (*fmt)(struct udp_err_event *);
+};
+
+void init_udp(logger_t *logger);
+void init_udp_endp_que(int ep);
+void add_udp_evnt_que_to_qset(QueueSetHandle_t qset);
+enum udp_state get_udp_state(void);
+void set_udp_addr(int addr);
+void set_udp_confg(boolean_t conf);
+void enable_udp_endp(int ep, int type);
+void disable_udp_endp(int ep);
+boolean_t is_udp_endp_enabled(int ep);
+enum udp_endp_dir get_udp_endp_dir(int ep);
+void halt_udp_endp(int ep);
+void un_halt_udp_endp(int ep);
+boolean_t is_udp_endp_halted(int ep);
+boolean_t get_rmt_wkup_feat(void);
+void set_rmt_wkup_feat(boolean_t feat);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * usb_ctl_req.h
+ *
+ * Host simulation stand-in for the control request layer. Registered
+ * callback sets are driven by sim_ctl() (sim/sim.c).
+ */
+
+#ifndef USB_CTL_REQ_H
+#define USB_CTL_REQ_H
+
+enum usb_ctl_req_recp {
+	USB_DEVICE_RECIPIENT,
+	USB_IFACE_RECIPIENT,
+	USB_ENDP_RECIPIENT,
+	USB_OTHER_RECIPIENT
+};
+
+enum usb_ctl_req_type {
+	USB_STANDARD_REQUEST,
+	USB_CLASS_REQUEST,
+	USB_VENDOR_REQUEST
+};
+
+/*
+ * Setup callback result: valid (FALSE - stall), data stage buffer, nmb bytes
+ * to send or receive, trans_nmb bytes requested by host (w_length) and
+ * direction.
+ */
+struct usb_ctl_req {
+	boolean_t valid;
+	uint8_t *buf;
+	int nmb;
+	int trans_nmb;
+	int trans_dir;
+};
+
+struct usb_ctl_req_clbks {
+	struct usb_ctl_req (*stp_clbk)(struct usb_stp_pkt *);
+	void (*in_req_ack_clbk)(void);
+	boolean_t (*out_req_rec_clbk)(void);
+	void (*out_req_ack_clbk)(void);
+};
+
+#define USB_CTL_REQ_EVENT_TYPE 6
+
+struct usb_ctl_req_event {
+	int8_t type;
+	uint8_t state;
+	void (*fmt)(struct usb_ctl_req_event *);
+};
+
+void init_usb_ctl_req(logger_t *logger);
+void add_usb_ctl_req_std_clbks(struct usb_ctl_req_clbks *clbks);
+void add_usb_ctl_req_cls_clbks(struct usb_ctl_req_clbks *clbks);
+void add_usb_ctl_req_vnd_clbks(struct usb_ctl_req_clbks *clbks);
+
+/**
+ * find_usb_endp_desc
+ *
+ * Returns next endpoint descriptor of configuration descriptor set desc
+ * (size bytes) on each call, NULL after the last one (iteration restarts).
+ */
+const struct usb_endp_desc *find_usb_endp_desc(const void *desc, int size);
+int usb_endp_desc_get_ep_type(const struct usb_endp_desc *ed);
+
+#endif
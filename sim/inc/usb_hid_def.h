@@ -0,0 +1,38 @@
+/*
+ * usb_hid_def.h
+ *
+ * Host simulation stand-in for HID class definitions.
+ */
+
+#ifndef USB_HID_DEF_H
+#define USB_HID_DEF_H
+
+#define USB_HID_CLASS 3
+#define USB_HID_SUBCLASS_NO_BOOT 0
+#define USB_HID_DESC 0x21
+#define USB_HID_REPORT_DESC 0x22
+#define USB_HID_PHYSICAL_DESC 0x23
+#define USB_HID_REL_1_11_VER_BCD 0x0111
+
+#define USB_HID_GET_REPORT 1
+#define USB_HID_GET_IDLE 2
+#define USB_HID_GET_PROTOCOL 3
+#define USB_HID_SET_REPORT 9
+#define USB_HID_SET_IDLE 10
+#define USB_HID_SET_PROTOCOL 11
+
+#define USB_HID_REPORT_IN 1
+#define USB_HID_REPORT_OUT 2
+#define USB_HID_REPORT_FEATURE 3
+
+struct usb_hid_desc {
+	uint8_t size;
+	uint8_t type;
+	uint16_t bcd_hid;
+	uint8_t country_code;
+	uint8_t num_descs;
+	uint8_t rep_desc_type;
+	uint16_t rep_desc_size;
+} __attribute__ ((packed));
+
+#endif
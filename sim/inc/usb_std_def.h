@@ -0,0 +1,98 @@
+/*
+ * usb_std_def.h
+ *
+ * Host simulation stand-in for USB 2.0 chapter 9 definitions.
+ */
+
+#ifndef USB_STD_DEF_H
+#define USB_STD_DEF_H
+
+#define USB_DEV_DESC 1
+#define USB_CONF_DESC 2
+#define USB_STR_DESC 3
+#define USB_IFACE_DESC 4
+#define USB_ENDP_DESC 5
+#define USB_DEV_QUAL_DESC 6
+#define USB_ALT_SPEED_CONF_DESC 7
+
+#define USB_GET_STATUS 0
+#define USB_CLEAR_FEATURE 1
+#define USB_SET_FEATURE 3
+#define USB_SET_ADDRESS 5
+#define USB_GET_DESCRIPTOR 6
+#define USB_SET_DESCRIPTOR 7
+#define USB_GET_CONFIGURATION 8
+#define USB_SET_CONFIGURATION 9
+#define USB_GET_INTERFACE 10
+#define USB_SET_INTERFACE 11
+#define USB_SYNCH_FRAME 12
+
+#define USB_ENDP_HALT_FEAT 0
+#define USB_DEV_REM_WKUP_FEAT 1
+#define USB_TEST_MODE_FEAT 2
+
+#define USB_STD_USB2_00_VER_BCD 0x0200
+#define USB_STD_BUS_POWER_NO_RWAKE 0x80
+#define USB_STD_EN_US_CODE 0x09, 0x04
+#define USB_STD_IN_ENDP 1
+#define USB_STD_OUT_ENDP 0
+#define USB_STD_TRANS_CONTROL 0
+#define USB_STD_TRANS_ISOCHRONOUS 1
+#define USB_STD_TRANS_BULK 2
+#define USB_STD_TRANS_INTERRUPT 3
+
+#define usb_std_max_power_mamp(ma) ((ma) / 2)
+#define usb_std_endp_addr(num, dir) ((num) | ((dir) << 7))
+#define usb_std_str_desc_size(n) (2 + 2 * (n))
+#define usb_std_unicode(c) (c), 0
+
+struct usb_dev_desc {
+	uint8_t size;
+	uint8_t type;
+	uint16_t bcd_usb;
+	uint8_t b_device_class;
+	uint8_t b_device_subclass;
+	uint8_t b_device_protocol;
+	uint8_t b_max_packet_size0;
+	uint16_t id_vendor;
+	uint16_t id_product;
+	uint16_t bcd_device;
+	uint8_t i_manufacturer;
+	uint8_t i_product;
+	uint8_t i_serial_number;
+	uint8_t b_num_configurations;
+} __attribute__ ((packed));
+
+struct usb_conf_desc {
+	uint8_t size;
+	uint8_t type;
+	uint16_t w_total_size;
+	uint8_t b_num_interfaces;
+	uint8_t b_configuration_value;
+	uint8_t i_configuration;
+	uint8_t bm_attributes;
+	uint8_t b_max_power;
+} __attribute__ ((packed));
+
+struct usb_iface_desc {
+	uint8_t size;
+	uint8_t type;
+	uint8_t b_interface_number;
+	uint8_t b_alternate_setting;
+	uint8_t b_num_endpoints;
+	uint8_t b_interface_class;
+	uint8_t b_interface_subclass;
+	uint8_t b_interface_protocol;
+	uint8_t i_interface;
+} __attribute__ ((packed));
+
+struct usb_endp_desc {
+	uint8_t size;
+	uint8_t type;
+	uint8_t b_endpoint_address;
+	uint8_t bm_attributes;
+	uint16_t w_max_packet_size;
+	uint8_t b_interval;
+} __attribute__ ((packed));
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * logtok.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Renders tokenized log (USB_JIG_LOG_TOKENS) captured from device terminal.
+ *
+ *   logtok < log.txt
+ *
+ * "@" token following "usb_jiggler.c: " is replaced by message text, other
+ * lines are copied.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "logtok_dec.h"
+
+#define LINE_SIZE 256
+#define TAG "usb_jiggler.c: @"
+
+/**
+ * main
+ */
+int main(void)
+{
+	char line[LINE_SIZE], txt[LINE_SIZE], *p;
+	int lno = 0;
+
+	while (fgets(line, sizeof(line), stdin)) {
+		lno++;
+		if (!(p = strstr(line, TAG))) {
+			fputs(line, stdout);
+			continue;
+		}
+		if (render_log_tok(p + strlen(TAG), txt, sizeof(txt)) < 0) {
+			fprintf(stderr, "logtok: line %d: bad token\n", lno);
+			fputs(line, stdout);
+			continue;
+		}
+		printf("%.*s%s\n", (int) (p - line + strlen(TAG) - 1), line, txt);
+	}
+	return (0);
+}
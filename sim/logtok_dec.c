@@ -0,0 +1,137 @@
+/*
+ * logtok_dec.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <ctype.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "logtok_dec.h"
+
+#define LOG_MSG_FMT(id, fmt) fmt,
+#define CMD_RES_TXT(id, txt) txt,
+
+static const char *const fmts[] = {
+	USB_JIG_LOG_MSG_LIST(LOG_MSG_FMT)
+};
+
+static const char *const cmd_res[] = {
+	USB_JIG_CMD_RES_LIST(CMD_RES_TXT)
+};
+
+static int hex_val(char c);
+static int decode(const char *tok, uint32_t *v, int max);
+
+/**
+ * hex_val
+ */
+static int hex_val(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return (c - '0');
+	}
+	if (c >= 'A' && c <= 'F') {
+		return (c - 'A' + 10);
+	}
+	return (-1);
+}
+
+/**
+ * decode
+ *
+ * Decodes LEB128 numbers of token into v, returns number of values or -1.
+ */
+static int decode(const char *tok, uint32_t *v, int max)
+{
+	int n = 0, sh = 0, h, l;
+	uint8_t b;
+
+	while ((h = hex_val(tok[0])) >= 0) {
+		if ((l = hex_val(tok[1])) < 0) {
+			return (-1);
+		}
+		tok += 2;
+		b = h << 4 | l;
+		if (sh == 0) {
+			if (n == max) {
+				return (-1);
+			}
+			v[n] = 0;
+		} else if (sh > 28) {
+			return (-1);
+		}
+		v[n] |= (uint32_t) (b & 0x7F) << sh;
+		if (b & 0x80) {
+			sh += 7;
+		} else {
+			sh = 0;
+			n++;
+		}
+	}
+	return ((sh) ? -1 : n);
+}
+
+/**
+ * render_log_tok
+ */
+int render_log_tok(const char *tok, char *out, int size)
+{
+	uint32_t v[1 + USB_JIG_LOG_TOK_MAX_ARGS];
+	const char *f;
+	int n, a = 1, len = 0, prec, w;
+
+	if ((n = decode(tok, v, 1 + USB_JIG_LOG_TOK_MAX_ARGS)) < 1 || v[0] >= USB_JIG_LOG_MSG_NMB) {
+		return (-1);
+	}
+	for (f = fmts[v[0]]; *f; f++) {
+		if (*f != '%') {
+			w = snprintf(out + len, size - len, "%c", *f);
+		} else {
+			prec = 0;
+			if (*++f == '.') {
+				for (f++; isdigit((unsigned char) *f); f++) {
+					prec = prec * 10 + *f - '0';
+				}
+			}
+			if (a == n) {
+				return (-1);
+			}
+			if (*f == 'u') {
+				w = snprintf(out + len, size - len, "%u", v[a++]);
+			} else if (*f == 'X') {
+				w = snprintf(out + len, size - len, "%.*X", prec, v[a++]);
+			} else if (*f == 's') {
+				if (v[a] >= USB_JIG_CMD_RES_NMB) {
+					return (-1);
+				}
+				w = snprintf(out + len, size - len, "%s", cmd_res[v[a++]]);
+			} else {
+				return (-1);
+			}
+		}
+		if (w >= size - len) {
+			return (-1);
+		}
+		len += w;
+	}
+	return ((a == n) ? len : -1);
+}
@@ -0,0 +1,37 @@
+/*
+ * logtok_dec.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef LOGTOK_DEC_H
+#define LOGTOK_DEC_H
+
+/*
+ * Host side renderer of tokenized log messages (USB_JIG_LOG_TOKENS, format
+ * at USB_JIG_LOG_MSG_LIST in usb_jiggler.h).
+ */
+
+/**
+ * render_log_tok
+ *
+ * Renders token tok (hex bytes following '@', ends at first non hex
+ * character) into out of size bytes. %s arguments are command result ids
+ * rendered by USB_JIG_CMD_RES_LIST.
+ * Returns length of text or -1 if token is malformed or out is too small.
+ */
+int render_log_tok(const char *tok, char *out, int size);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * mktrace.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Converts recorded mouse trace to C table for start_mouse_trace().
+ *
+ *   mktrace name < trace.txt > trace.c
+ *
+ * Input has one frame per poll interval (USB_JIG_IN_M_ENDP_POLLED_MS) and
+ * line: x y [w [bm]] deltas -127..127, button state, '#' starts comment.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "trace_enc.h"
+
+#define LINE_SIZE 256
+
+/**
+ * main
+ */
+int main(int argc, char **argv)
+{
+	struct mouse_report *frms = NULL;
+	uint8_t *out;
+	char line[LINE_SIZE], *p;
+	int i, n = 0, cap = 0, len, x, y, w, bm = 0, lno = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: mktrace name < trace.txt > trace.c\n");
+		return (2);
+	}
+	while (fgets(line, sizeof(line), stdin)) {
+		lno++;
+		for (p = line; *p == ' ' || *p == '\t'; p++) {
+			;
+		}
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+			continue;
+		}
+		w = 0;
+		if (sscanf(p, "%d %d %d %d", &x, &y, &w, &bm) < 2) {
+			fprintf(stderr, "mktrace: line %d: bad frame\n", lno);
+			return (1);
+		}
+		if (x < -127 || x > 127 || y < -127 || y > 127 || w < -127 || w > 127 ||
+		    bm < 0 || bm > 255) {
+			fprintf(stderr, "mktrace: line %d: value out of range\n", lno);
+			return (1);
+		}
+		if (n == cap) {
+			cap = (cap) ? 2 * cap : 1024;
+			if (!(frms = realloc(frms, cap * sizeof(struct mouse_report)))) {
+				fprintf(stderr, "mktrace: out of memory\n");
+				return (1);
+			}
+		}
+		frms[n].x = x;
+		frms[n].y = y;
+		frms[n].w = w;
+		frms[n].bm = bm;
+		n++;
+	}
+	// Worst case is 5 bytes per frame and end code.
+	if (!(out = malloc(5 * n + 1)) || (len = encode_mouse_trace(frms, n, out, 5 * n + 1)) < 0) {
+		fprintf(stderr, "mktrace: encoding failed\n");
+		return (1);
+	}
+	printf("// %d frames, %d bytes (mktrace)\n", n, len);
+	printf("const uint8_t %s[%d] = {", argv[1], len);
+	for (i = 0; i < len; i++) {
+		printf("%s0x%02X%s", (i % 12) ? " " : "\n\t", out[i], (i < len - 1) ? "," : "\n");
+	}
+	printf("};\n");
+	return (0);
+}
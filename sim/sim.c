@@ -0,0 +1,1222 @@
+/*
+ * sim.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+#include <timers.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "criterr.h"
+#include "msgconf.h"
+#include "tools.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "sim.h"
+
+// Longest simulated wait of blocked call (deadlock guard).
+#define MAX_BLOCK_TICKS 10000000
+#define MSG_BUF_SIZE 65536
+#define TSK_NMB 8
+#define TMR_NMB 8
+#define PEND_NMB 16
+#define TSK_STACK_SIZE 65536
+
+struct sim_que {
+	int len;
+	int item_size;
+	int head;
+	int cnt;
+	uint8_t *buf;
+	struct sim_que *set;
+};
+
+struct sim_tsk {
+	const char *nm;
+	void (*fn)(void *);
+	void *arg;
+	uint32_t ntf_val;
+	boolean_t ntf_pend;
+	ucontext_t ctx;
+	void *stk;
+};
+
+struct sim_tmr {
+	const char *nm;
+	TickType_t per;
+	boolean_t reload;
+	boolean_t active;
+	TickType_t exp;
+	void (*clbk)(TimerHandle_t);
+};
+
+TickType_t sim_tick;
+int sim_msg_echo;
+int sim_no_block;
+void (*sim_block_hook)(void);
+struct sim_xfer sim_last;
+struct sim_ctl_stats sim_ctl_stats;
+
+static struct sim_tsk tsks[TSK_NMB] = {{.nm = "main"}};
+static int tsk_nmb = 1;
+TaskHandle_t sim_cur_tsk = &tsks[0];
+static struct sim_tmr tmrs[TMR_NMB];
+static int tmr_nmb;
+static struct {
+	void (*fn)(void *, uint32_t);
+	void *p;
+	uint32_t u;
+} pend[PEND_NMB];
+static int pend_nmb;
+static int crit_nest;
+
+static char msg_buf[MSG_BUF_SIZE];
+static int msg_len;
+static int fail_cnt, check_cnt;
+
+static enum udp_state udp_state = UDP_STATE_POWERED;
+static int udp_addr;
+static boolean_t endp_en[UDP_EP_NMB], endp_halt[UDP_EP_NMB], endp_que[UDP_EP_NMB];
+static boolean_t rmt_wkup;
+static QueueHandle_t udp_evnt_que;
+static logger_t *udp_logger;
+static struct usb_ctl_req_clbks *ctl_clbks[3];
+static struct usb_stp_pkt stp_pkt;
+
+static void fatal(const char *txt);
+static void check_block(TickType_t tmo);
+static void tsk_entry(void);
+static void yield_tsk(void);
+static BaseType_t wait_for(struct sim_que *q, boolean_t space, TickType_t tmo);
+static BaseType_t wait_for_ntf(TickType_t tmo);
+static void post_udp_evnt(enum udp_state st);
+#if UDP_LOG_STATE_EVENTS == 1
+static void fmt_udp_state_event(struct udp_state_event *p);
+#endif
+
+/**
+ * fatal
+ */
+static void fatal(const char *txt)
+{
+	fprintf(stderr, "sim: %s\n", txt);
+	abort();
+}
+
+/**
+ * check_block
+ *
+ * Call which is going to wait tmo ticks must not block in idle hook and
+ * timer service task.
+ */
+static void check_block(TickType_t tmo)
+{
+	if (tmo && sim_no_block) {
+		fatal("blocking call in idle hook or timer service task");
+	}
+}
+
+/**
+ * sim_cycles
+ */
+uint64_t sim_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (__rdtsc());
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+#endif
+}
+
+/**
+ * sim_advance
+ */
+void sim_advance(TickType_t ticks)
+{
+	int i;
+
+	while (ticks--) {
+		sim_tick++;
+		for (i = 0; i < tmr_nmb; i++) {
+			if (tmrs[i].active && sim_tick == tmrs[i].exp) {
+				if (tmrs[i].reload) {
+					tmrs[i].exp += tmrs[i].per;
+				} else {
+					tmrs[i].active = FALSE;
+				}
+				sim_no_block++;
+				tmrs[i].clbk(&tmrs[i]);
+				sim_no_block--;
+			}
+		}
+		// Pended functions may pend more work, run up to current count.
+		for (i = 0; i < pend_nmb; i++) {
+			sim_no_block++;
+			pend[i].fn(pend[i].p, pend[i].u);
+			sim_no_block--;
+		}
+		if (i) {
+			memmove(pend, pend + i, (pend_nmb - i) * sizeof(pend[0]));
+			pend_nmb -= i;
+		}
+	}
+}
+
+/**
+ * sim_run_tasks
+ */
+void sim_run_tasks(void)
+{
+	int i;
+
+	if (sim_cur_tsk != &tsks[0]) {
+		fatal("sim_run_tasks() called by task");
+	}
+	for (i = 1; i < tsk_nmb; i++) {
+		if (!tsks[i].stk) {
+			if (!(tsks[i].stk = malloc(TSK_STACK_SIZE))) {
+				fatal("no memory for task stack");
+			}
+			getcontext(&tsks[i].ctx);
+			tsks[i].ctx.uc_stack.ss_sp = tsks[i].stk;
+			tsks[i].ctx.uc_stack.ss_size = TSK_STACK_SIZE;
+			tsks[i].ctx.uc_link = NULL;
+			makecontext(&tsks[i].ctx, tsk_entry, 0);
+		}
+		sim_cur_tsk = &tsks[i];
+		swapcontext(&tsks[0].ctx, &tsks[i].ctx);
+		sim_cur_tsk = &tsks[0];
+	}
+}
+
+/**
+ * tsk_entry
+ */
+static void tsk_entry(void)
+{
+	sim_cur_tsk->fn(sim_cur_tsk->arg);
+	fatal("task function returned");
+}
+
+/**
+ * yield_tsk
+ *
+ * Created task blocks, main runs until next sim_run_tasks().
+ */
+static void yield_tsk(void)
+{
+	swapcontext(&sim_cur_tsk->ctx, &tsks[0].ctx);
+}
+
+/**
+ * sim_enter_critical
+ */
+void sim_enter_critical(void)
+{
+	crit_nest++;
+}
+
+/**
+ * sim_exit_critical
+ */
+void sim_exit_critical(void)
+{
+	if (--crit_nest < 0) {
+		fatal("unbalanced critical section");
+	}
+}
+
+/**
+ * wait_for
+ */
+static BaseType_t wait_for(struct sim_que *q, boolean_t space, TickType_t tmo)
+{
+	TickType_t n = 0, start = sim_tick;
+
+	while (space ? q->cnt == q->len : q->cnt == 0) {
+		check_block(tmo);
+		if (sim_cur_tsk != &tsks[0]) {
+			if (tmo != portMAX_DELAY && sim_tick - start >= tmo) {
+				return (pdFALSE);
+			}
+			yield_tsk();
+			continue;
+		}
+		if (tmo != portMAX_DELAY && n >= tmo) {
+			return (pdFALSE);
+		}
+		if (!sim_block_hook) {
+			if (tmo == portMAX_DELAY) {
+				fatal("task blocked forever");
+			}
+			sim_advance(tmo - n);
+			return (pdFALSE);
+		}
+		if (++n > MAX_BLOCK_TICKS) {
+			fatal("task blocked forever");
+		}
+		sim_advance(1);
+		sim_block_hook();
+	}
+	return (pdTRUE);
+}
+
+/**
+ * xQueueCreate
+ */
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size)
+{
+	struct sim_que *q;
+
+	if (!(q = calloc(1, sizeof(struct sim_que))) ||
+	    !(q->buf = calloc(len, item_size ? item_size : 1))) {
+		return (NULL);
+	}
+	q->len = len;
+	q->item_size = item_size;
+	return (q);
+}
+
+/**
+ * xQueueCreateStatic
+ */
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size, uint8_t *buf,
+				 StaticQueue_t *stc)
+{
+	struct sim_que *q = (struct sim_que *) stc;
+
+	_Static_assert(sizeof(struct sim_que) <= sizeof(StaticQueue_t), "StaticQueue_t size");
+	memset(q, 0, sizeof(struct sim_que));
+	q->len = len;
+	q->item_size = item_size;
+	q->buf = buf;
+	return (q);
+}
+
+/**
+ * xQueueSend
+ */
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t tmo)
+{
+	if (!wait_for(q, TRUE, tmo)) {
+		return (pdFALSE);
+	}
+	if (q->item_size) {
+		memcpy(q->buf + ((q->head + q->cnt) % q->len) * q->item_size, item, q->item_size);
+	}
+	q->cnt++;
+	if (q->set && xQueueSend(q->set, &q, 0) != pdTRUE) {
+		fatal("queue set overflow");
+	}
+	return (pdTRUE);
+}
+
+/**
+ * xQueueSendFromISR
+ */
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *hpw)
+{
+	return (xQueueSend(q, item, 0));
+}
+
+/**
+ * xQueueReceive
+ */
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t tmo)
+{
+	if (!wait_for(q, FALSE, tmo)) {
+		return (pdFALSE);
+	}
+	if (q->item_size) {
+		memcpy(item, q->buf + q->head * q->item_size, q->item_size);
+	}
+	q->head = (q->head + 1) % q->len;
+	q->cnt--;
+	return (pdTRUE);
+}
+
+/**
+ * xQueueReceiveFromISR
+ */
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *hpw)
+{
+	return (xQueueReceive(q, item, 0));
+}
+
+/**
+ * uxQueueMessagesWaiting
+ */
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+	return (q->cnt);
+}
+
+/**
+ * xQueueCreateSet
+ */
+QueueSetHandle_t xQueueCreateSet(UBaseType_t len)
+{
+	return (xQueueCreate(len, sizeof(QueueSetMemberHandle_t)));
+}
+
+/**
+ * xQueueCreateSetStatic
+ */
+QueueSetHandle_t xQueueCreateSetStatic(UBaseType_t len, uint8_t *buf, StaticQueue_t *stc)
+{
+	return (xQueueCreateStatic(len, sizeof(QueueSetMemberHandle_t), buf, stc));
+}
+
+/**
+ * xQueueAddToSet
+ */
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t mbr, QueueSetHandle_t set)
+{
+	if (mbr->set || mbr->cnt) {
+		return (pdFAIL);
+	}
+	mbr->set = set;
+	return (pdPASS);
+}
+
+/**
+ * xQueueSelectFromSet
+ */
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t tmo)
+{
+	QueueSetMemberHandle_t mbr;
+
+	if (xQueueReceive(set, &mbr, tmo) != pdTRUE) {
+		return (NULL);
+	}
+	return (mbr);
+}
+
+/**
+ * xSemaphoreCreateBinary
+ */
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return (xQueueCreate(1, 0));
+}
+
+/**
+ * xSemaphoreCreateBinaryStatic
+ */
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *stc)
+{
+	static uint8_t dmy;
+
+	return (xQueueCreateStatic(1, 0, &dmy, stc));
+}
+
+/**
+ * xTaskCreate
+ */
+BaseType_t xTaskCreate(void (*fn)(void *), const char *nm, uint32_t stack, void *arg,
+		       UBaseType_t prio, TaskHandle_t *hndl)
+{
+	struct sim_tsk *t;
+
+	if (tsk_nmb == TSK_NMB) {
+		return (pdFAIL);
+	}
+	t = &tsks[tsk_nmb++];
+	t->nm = nm;
+	t->fn = fn;
+	t->arg = arg;
+	if (hndl) {
+		*hndl = t;
+	}
+	return (pdPASS);
+}
+
+/**
+ * xTaskCreateStatic
+ */
+TaskHandle_t xTaskCreateStatic(void (*fn)(void *), const char *nm, uint32_t stack, void *arg,
+			       UBaseType_t prio, StackType_t *stk, StaticTask_t *stc)
+{
+	TaskHandle_t t = NULL;
+
+	xTaskCreate(fn, nm, stack, arg, prio, &t);
+	return (t);
+}
+
+/**
+ * xTaskGetCurrentTaskHandle
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return (sim_cur_tsk);
+}
+
+/**
+ * xTaskGetTickCount
+ */
+TickType_t xTaskGetTickCount(void)
+{
+	return (sim_tick);
+}
+
+/**
+ * xTaskGetTickCountFromISR
+ */
+TickType_t xTaskGetTickCountFromISR(void)
+{
+	return (sim_tick);
+}
+
+/**
+ * vTaskDelay
+ */
+void vTaskDelay(TickType_t ticks)
+{
+	check_block(ticks);
+	while (ticks--) {
+		sim_advance(1);
+		if (sim_block_hook) {
+			sim_block_hook();
+		}
+	}
+}
+
+/**
+ * vTaskSetTimeOutState
+ */
+void vTaskSetTimeOutState(TimeOut_t *to)
+{
+	to->start = sim_tick;
+}
+
+/**
+ * xTaskCheckForTimeOut
+ */
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *to, TickType_t *tmo)
+{
+	TickType_t d;
+
+	if (*tmo == portMAX_DELAY) {
+		return (pdFALSE);
+	}
+	d = sim_tick - to->start;
+	if (d >= *tmo) {
+		*tmo = 0;
+		return (pdTRUE);
+	}
+	*tmo -= d;
+	to->start = sim_tick;
+	return (pdFALSE);
+}
+
+/**
+ * xTaskNotify
+ */
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t val, eNotifyAction act)
+{
+	switch (act) {
+	case eSetBits :
+		t->ntf_val |= val;
+		break;
+	case eIncrement :
+		t->ntf_val++;
+		break;
+	case eSetValueWithOverwrite :
+		t->ntf_val = val;
+		break;
+	case eSetValueWithoutOverwrite :
+		if (t->ntf_pend) {
+			return (pdFAIL);
+		}
+		t->ntf_val = val;
+		break;
+	default :
+		break;
+	}
+	t->ntf_pend = TRUE;
+	return (pdPASS);
+}
+
+/**
+ * xTaskNotifyFromISR
+ */
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t val, eNotifyAction act, BaseType_t *hpw)
+{
+	return (xTaskNotify(t, val, act));
+}
+
+/**
+ * wait_for_ntf
+ */
+static BaseType_t wait_for_ntf(TickType_t tmo)
+{
+	TickType_t n = 0, start = sim_tick;
+
+	while (!sim_cur_tsk->ntf_pend) {
+		check_block(tmo);
+		if (sim_cur_tsk != &tsks[0]) {
+			if (tmo != portMAX_DELAY && sim_tick - start >= tmo) {
+				return (pdFALSE);
+			}
+			yield_tsk();
+			continue;
+		}
+		if (tmo != portMAX_DELAY && n >= tmo) {
+			return (pdFALSE);
+		}
+		if (!sim_block_hook) {
+			if (tmo == portMAX_DELAY) {
+				fatal("task blocked forever");
+			}
+			sim_advance(tmo - n);
+			return (pdFALSE);
+		}
+		if (++n > MAX_BLOCK_TICKS) {
+			fatal("task blocked forever");
+		}
+		sim_advance(1);
+		sim_block_hook();
+	}
+	return (pdTRUE);
+}
+
+/**
+ * xTaskNotifyWait
+ */
+BaseType_t xTaskNotifyWait(uint32_t clr_entry, uint32_t clr_exit, uint32_t *val, TickType_t tmo)
+{
+	if (!sim_cur_tsk->ntf_pend) {
+		sim_cur_tsk->ntf_val &= ~clr_entry;
+	}
+	if (!wait_for_ntf(tmo)) {
+		return (pdFALSE);
+	}
+	if (val) {
+		*val = sim_cur_tsk->ntf_val;
+	}
+	sim_cur_tsk->ntf_val &= ~clr_exit;
+	sim_cur_tsk->ntf_pend = FALSE;
+	return (pdTRUE);
+}
+
+/**
+ * vTaskNotifyGiveFromISR
+ */
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *hpw)
+{
+	xTaskNotify(t, 0, eIncrement);
+}
+
+/**
+ * ulTaskNotifyTake
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clr, TickType_t tmo)
+{
+	uint32_t v;
+
+	if (!sim_cur_tsk->ntf_val) {
+		sim_cur_tsk->ntf_pend = FALSE;
+		if (!wait_for_ntf(tmo)) {
+			return (0);
+		}
+	}
+	v = sim_cur_tsk->ntf_val;
+	sim_cur_tsk->ntf_val = clr ? 0 : v - 1;
+	sim_cur_tsk->ntf_pend = FALSE;
+	return (v);
+}
+
+/**
+ * xTimerCreate
+ */
+TimerHandle_t xTimerCreate(const char *nm, TickType_t per, UBaseType_t reload, void *id,
+			   void (*clbk)(TimerHandle_t))
+{
+	struct sim_tmr *t;
+
+	if (tmr_nmb == TMR_NMB) {
+		return (NULL);
+	}
+	t = &tmrs[tmr_nmb++];
+	t->nm = nm;
+	t->per = per;
+	t->reload = reload;
+	t->clbk = clbk;
+	return (t);
+}
+
+/**
+ * xTimerCreateStatic
+ */
+TimerHandle_t xTimerCreateStatic(const char *nm, TickType_t per, UBaseType_t reload, void *id,
+				 void (*clbk)(TimerHandle_t), StaticTimer_t *stc)
+{
+	return (xTimerCreate(nm, per, reload, id, clbk));
+}
+
+/**
+ * xTimerStart
+ */
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t tmo)
+{
+	t->active = TRUE;
+	t->exp = sim_tick + t->per;
+	return (pdPASS);
+}
+
+/**
+ * xTimerPendFunctionCall
+ */
+BaseType_t xTimerPendFunctionCall(void (*fn)(void *, uint32_t), void *p, uint32_t u,
+				  TickType_t tmo)
+{
+	if (pend_nmb == PEND_NMB) {
+		return (pdFAIL);
+	}
+	pend[pend_nmb].fn = fn;
+	pend[pend_nmb].p = p;
+	pend[pend_nmb].u = u;
+	pend_nmb++;
+	return (pdPASS);
+}
+
+/**
+ * xTimerPendFunctionCallFromISR
+ */
+BaseType_t xTimerPendFunctionCallFromISR(void (*fn)(void *, uint32_t), void *p, uint32_t u,
+					 BaseType_t *hpw)
+{
+	return (xTimerPendFunctionCall(fn, p, u, 0));
+}
+
+/**
+ * crit_err_exit
+ */
+void crit_err_exit(int err)
+{
+	fprintf(stderr, "sim: crit_err_exit(%d)\n", err);
+	abort();
+}
+
+/**
+ * msg
+ */
+void msg(int lev, const char *fmt, ...)
+{
+	char txt[256];
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(txt, sizeof(txt), fmt, ap);
+	va_end(ap);
+	if (n >= (int) sizeof(txt)) {
+		n = sizeof(txt) - 1;
+	}
+	if (msg_len + n >= MSG_BUF_SIZE) {
+		msg_len = 0;
+	}
+	memcpy(msg_buf + msg_len, txt, n + 1);
+	msg_len += n;
+	if (sim_msg_echo) {
+		fputs(txt, stdout);
+	}
+}
+
+/**
+ * sim_msg_text
+ */
+const char *sim_msg_text(void)
+{
+	return (msg_buf);
+}
+
+/**
+ * sim_msg_clear
+ */
+void sim_msg_clear(void)
+{
+	msg_len = 0;
+	msg_buf[0] = '\0';
+}
+
+/**
+ * find_txt_item
+ */
+const char *find_txt_item(int code, const struct txt_item *ary, const char *dflt)
+{
+	for (; ary->txt; ary++) {
+		if (ary->code == code) {
+			return (ary->txt);
+		}
+	}
+	return (dflt);
+}
+
+/**
+ * init_udp
+ */
+void init_udp(logger_t *logger)
+{
+	udp_state = UDP_STATE_POWERED;
+	udp_logger = logger;
+}
+
+/**
+ * sim_logger_que_bytes
+ */
+size_t sim_logger_que_bytes(void)
+{
+	if (!udp_logger) {
+		return (0);
+	}
+	return ((size_t) udp_logger->que->len * udp_logger->que->item_size);
+}
+
+/**
+ * init_udp_endp_que
+ */
+void init_udp_endp_que(int ep)
+{
+	endp_que[ep] = TRUE;
+}
+
+/**
+ * add_udp_evnt_que_to_qset
+ */
+void add_udp_evnt_que_to_qset(QueueSetHandle_t qset)
+{
+	if (!udp_evnt_que && !(udp_evnt_que = xQueueCreate(UDP_EVNT_QUE_SIZE, sizeof(enum udp_state)))) {
+		crit_err_exit(MALLOC_ERROR);
+	}
+	if (xQueueAddToSet(udp_evnt_que, qset) != pdPASS) {
+		crit_err_exit(BAD_PARAMETER);
+	}
+}
+
+/**
+ * post_udp_evnt
+ */
+static void post_udp_evnt(enum udp_state st)
+{
+#if UDP_LOG_STATE_EVENTS == 1
+	// Queue copies its item size, it may be larger than event.
+	union {
+		struct udp_state_event e;
+		uint8_t b[64];
+	} u;
+
+	memset(&u, 0, sizeof(u));
+	u.e.type = UDP_STATE_EVENT_TYPE;
+	u.e.state = st;
+	u.e.fmt = fmt_udp_state_event;
+	if (udp_logger && xQueueSendFromISR(udp_logger->que, &u, NULL) != pdTRUE) {
+		udp_logger->que_err();
+	}
+#endif
+	if (udp_evnt_que && xQueueSendFromISR(udp_evnt_que, &st, NULL) != pdTRUE) {
+		fatal("udp event queue full");
+	}
+}
+
+#if UDP_LOG_STATE_EVENTS == 1
+/**
+ * fmt_udp_state_event
+ */
+static void fmt_udp_state_event(struct udp_state_event *p)
+{
+	msg(INF, "udp.c: state=%hhu\n", p->state);
+}
+#endif
+
+/**
+ * get_udp_state
+ */
+enum udp_state get_udp_state(void)
+{
+	return (udp_state);
+}
+
+/**
+ * set_udp_addr
+ */
+void set_udp_addr(int addr)
+{
+	udp_addr = addr;
+	udp_state = addr ? UDP_STATE_ADDRESSED : UDP_STATE_DEFAULT;
+	post_udp_evnt(udp_state);
+}
+
+/**
+ * set_udp_confg
+ */
+void set_udp_confg(boolean_t conf)
+{
+	udp_state = conf ? UDP_STATE_CONFIGURED : UDP_STATE_ADDRESSED;
+	post_udp_evnt(udp_state);
+}
+
+/**
+ * enable_udp_endp
+ */
+void enable_udp_endp(int ep, int type)
+{
+	if (ep <= 0 || ep >= UDP_EP_NMB || !endp_que[ep]) {
+		fatal("enable_udp_endp: bad endpoint");
+	}
+	endp_en[ep] = TRUE;
+	endp_halt[ep] = FALSE;
+}
+
+/**
+ * disable_udp_endp
+ */
+void disable_udp_endp(int ep)
+{
+	endp_en[ep] = FALSE;
+	endp_halt[ep] = FALSE;
+}
+
+/**
+ * is_udp_endp_enabled
+ */
+boolean_t is_udp_endp_enabled(int ep)
+{
+	if (!ep) {
+		return (udp_state != UDP_STATE_POWERED);
+	}
+	return (ep < UDP_EP_NMB && endp_en[ep]);
+}
+
+/**
+ * get_udp_endp_dir
+ */
+enum udp_endp_dir get_udp_endp_dir(int ep)
+{
+	// Library has interrupt IN endpoints only.
+	return (ep ? UDP_ENDP_DIR_IN : UDP_ENDP_DIR_OUT);
+}
+
+/**
+ * halt_udp_endp
+ */
+void halt_udp_endp(int ep)
+{
+	endp_halt[ep] = TRUE;
+}
+
+/**
+ * un_halt_udp_endp
+ */
+void un_halt_udp_endp(int ep)
+{
+	endp_halt[ep] = FALSE;
+}
+
+/**
+ * is_udp_endp_halted
+ */
+boolean_t is_udp_endp_halted(int ep)
+{
+	return (endp_halt[ep]);
+}
+
+/**
+ * get_rmt_wkup_feat
+ */
+boolean_t get_rmt_wkup_feat(void)
+{
+	return (rmt_wkup);
+}
+
+/**
+ * set_rmt_wkup_feat
+ */
+void set_rmt_wkup_feat(boolean_t feat)
+{
+	rmt_wkup = feat;
+}
+
+/**
+ * sim_bus_reset
+ */
+void sim_bus_reset(void)
+{
+	int i;
+
+	udp_addr = 0;
+	rmt_wkup = FALSE;
+	for (i = 0; i < UDP_EP_NMB; i++) {
+		endp_en[i] = FALSE;
+		endp_halt[i] = FALSE;
+	}
+	udp_state = UDP_STATE_DEFAULT;
+	post_udp_evnt(udp_state);
+}
+
+/**
+ * sim_suspend
+ */
+void sim_suspend(void)
+{
+	udp_state = UDP_STATE_SUSPENDED;
+	post_udp_evnt(udp_state);
+}
+
+/**
+ * sim_udp_evnt_que
+ */
+QueueHandle_t sim_udp_evnt_que(void)
+{
+	return (udp_evnt_que);
+}
+
+/**
+ * sim_udp_addr
+ */
+int sim_udp_addr(void)
+{
+	return (udp_addr);
+}
+
+/**
+ * sim_endp_que_ready
+ */
+boolean_t sim_endp_que_ready(int ep)
+{
+	return (endp_que[ep]);
+}
+
+/**
+ * init_usb_ctl_req
+ */
+void init_usb_ctl_req(logger_t *logger)
+{
+}
+
+/**
+ * add_usb_ctl_req_std_clbks
+ */
+void add_usb_ctl_req_std_clbks(struct usb_ctl_req_clbks *clbks)
+{
+	ctl_clbks[USB_STANDARD_REQUEST] = clbks;
+}
+
+/**
+ * add_usb_ctl_req_cls_clbks
+ */
+void add_usb_ctl_req_cls_clbks(struct usb_ctl_req_clbks *clbks)
+{
+	ctl_clbks[USB_CLASS_REQUEST] = clbks;
+}
+
+/**
+ * add_usb_ctl_req_vnd_clbks
+ */
+void add_usb_ctl_req_vnd_clbks(struct usb_ctl_req_clbks *clbks)
+{
+	ctl_clbks[USB_VENDOR_REQUEST] = clbks;
+}
+
+/**
+ * find_usb_endp_desc
+ */
+const struct usb_endp_desc *find_usb_endp_desc(const void *desc, int size)
+{
+	static const void *it_desc;
+	static int it_off;
+	const uint8_t *p;
+
+	if (desc != it_desc) {
+		it_desc = desc;
+		it_off = 0;
+	}
+	while (it_off + 2 <= size) {
+		p = (const uint8_t *) desc + it_off;
+		if (!p[0]) {
+			break;
+		}
+		it_off += p[0];
+		if (p[1] == USB_ENDP_DESC) {
+			return ((const struct usb_endp_desc *) p);
+		}
+	}
+	it_desc = NULL;
+	return (NULL);
+}
+
+/**
+ * usb_endp_desc_get_ep_type
+ */
+int usb_endp_desc_get_ep_type(const struct usb_endp_desc *ed)
+{
+	return (ed->bm_attributes & 3);
+}
+
+/**
+ * sim_ctl
+ */
+int sim_ctl(uint8_t bm, uint8_t req, uint16_t val, uint16_t idx, uint16_t len,
+	    const void *out, void *in)
+{
+	struct usb_ctl_req_clbks *c;
+	struct sim_xfer *x = &sim_last;
+	uint64_t t;
+	int n = 0;
+
+	memset(x, 0, sizeof(struct sim_xfer));
+	stp_pkt.bm_request_type = bm;
+	stp_pkt.b_request = req;
+	stp_pkt.w_value = val;
+	stp_pkt.w_index = idx;
+	stp_pkt.w_length = len;
+	x->stp = stp_pkt;
+	sim_ctl_stats.xfers++;
+	sim_ctl_stats.pkts++;
+	sim_ctl_stats.bus_us += SIM_XFER_US;
+	sim_advance(SIM_XFER_US / 1000);
+	if (((bm >> 5) & 3) > USB_VENDOR_REQUEST || !(c = ctl_clbks[(bm >> 5) & 3])) {
+		goto stall;
+	}
+	t = sim_cycles();
+	x->ucr = c->stp_clbk(&stp_pkt);
+	sim_ctl_stats.dev_cycles += sim_cycles() - t;
+	if (!x->ucr.valid) {
+		goto stall;
+	}
+	if (x->ucr.trans_dir != ((bm & 0x80) ? UDP_CTL_TRANS_IN : UDP_CTL_TRANS_OUT) ||
+	    x->ucr.nmb > len || x->ucr.nmb > SIM_XFER_DATA_SIZE) {
+		sim_ctl_stats.proto_errs++;
+		goto stall;
+	}
+	if (bm & 0x80) {
+		n = x->ucr.nmb;
+		memcpy(x->data, x->ucr.buf, n);
+		if (in) {
+			memcpy(in, x->ucr.buf, n);
+		}
+		// Short transfer ends with short or zero length packet.
+		sim_ctl_stats.pkts += n / SIM_EP0_SIZE + ((n % SIM_EP0_SIZE || n < len) ? 1 : 0);
+		sim_ctl_stats.pkts++;
+		t = sim_cycles();
+		c->in_req_ack_clbk();
+		sim_ctl_stats.dev_cycles += sim_cycles() - t;
+	} else {
+		t = sim_cycles();
+		if (len) {
+			n = x->ucr.nmb;
+			memcpy(x->ucr.buf, out, n);
+			memcpy(x->data, out, n);
+			sim_ctl_stats.pkts += (n + SIM_EP0_SIZE - 1) / SIM_EP0_SIZE;
+			if (!c->out_req_rec_clbk()) {
+				sim_ctl_stats.dev_cycles += sim_cycles() - t;
+				goto stall;
+			}
+		}
+		sim_ctl_stats.pkts++;
+		c->out_req_ack_clbk();
+		sim_ctl_stats.dev_cycles += sim_cycles() - t;
+	}
+	x->nmb = n;
+	return (n);
+stall:
+	sim_ctl_stats.pkts++;
+	sim_ctl_stats.stalls++;
+	x->stall = TRUE;
+	return (-1);
+}
+
+/**
+ * sim_stp_cycles
+ */
+uint64_t sim_stp_cycles(uint8_t bm, uint8_t req, uint16_t val, uint16_t idx, uint16_t len,
+			int rounds)
+{
+	struct usb_ctl_req_clbks *c;
+	struct usb_stp_pkt pkt;
+	uint64_t t;
+
+	if (((bm >> 5) & 3) > USB_VENDOR_REQUEST || !(c = ctl_clbks[(bm >> 5) & 3])) {
+		fatal("no callbacks for request type");
+	}
+	pkt.bm_request_type = bm;
+	pkt.b_request = req;
+	pkt.w_value = val;
+	pkt.w_index = idx;
+	pkt.w_length = len;
+	t = sim_cycles();
+	while (rounds--) {
+		c->stp_clbk(&pkt);
+	}
+	return (sim_cycles() - t);
+}
+
+/**
+ * sim_get_desc
+ */
+int sim_get_desc(int recp, uint8_t type, uint8_t idx, uint16_t w_index, uint16_t len, void *in)
+{
+	return (sim_ctl(0x80 | recp, USB_GET_DESCRIPTOR, type << 8 | idx, w_index, len, NULL, in));
+}
+
+/**
+ * sim_reset_ctl_stats
+ */
+void sim_reset_ctl_stats(void)
+{
+	memset(&sim_ctl_stats, 0, sizeof(sim_ctl_stats));
+}
+
+/**
+ * sim_check
+ */
+void sim_check(int ok, const char *expr, const char *file, int line)
+{
+	check_cnt++;
+	if (!ok) {
+		fail_cnt++;
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+	}
+}
+
+/**
+ * sim_result
+ */
+int sim_result(const char *nm)
+{
+	if (fail_cnt) {
+		printf("%s: FAILED (%d of %d checks)\n", nm, fail_cnt, check_cnt);
+		return (1);
+	}
+	printf("%s: ok (%d checks)\n", nm, check_cnt);
+	return (0);
+}
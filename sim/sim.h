@@ -0,0 +1,192 @@
+/*
+ * sim.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+/*
+ * Host simulation of the library environment: FreeRTOS shim, UDP driver
+ * and control request layer stand-ins and scripted USB host.
+ *
+ * Bus time model: every control transfer takes one full-speed frame
+ * (SIM_XFER_US) and advances the tick count, so time stamps taken by the
+ * library (tick based USB_JIG_TIMESTAMP()) show simulated bus time.
+ */
+#define SIM_XFER_US 1000
+#define SIM_EP0_SIZE 64
+#define SIM_XFER_DATA_SIZE 512
+
+extern TickType_t sim_tick;
+extern int sim_msg_echo;
+
+/*
+ * Nonzero while timer callback or pended function runs (set by
+ * sim_advance()) or while test code stands for idle hook. Call which would
+ * block aborts the simulation.
+ */
+extern int sim_no_block;
+extern TaskHandle_t sim_cur_tsk;
+
+/*
+ * Called every tick while the current task would block, e.g. to run
+ * interrupt handlers of other simulated contexts.
+ */
+extern void (*sim_block_hook)(void);
+
+/*
+ * Control transfer record. ucr is the setup callback result, stall is set
+ * if the transfer ended with STALL handshake.
+ */
+struct sim_xfer {
+	struct usb_stp_pkt stp;
+	struct usb_ctl_req ucr;
+	boolean_t stall;
+	int nmb;
+	uint8_t data[SIM_XFER_DATA_SIZE];
+};
+
+struct sim_ctl_stats {
+	unsigned int xfers;
+	unsigned int stalls;
+	unsigned int pkts;
+	unsigned int proto_errs;
+	uint64_t bus_us;
+	uint64_t dev_cycles;
+};
+
+extern struct sim_xfer sim_last;
+extern struct sim_ctl_stats sim_ctl_stats;
+
+/**
+ * sim_cycles
+ *
+ * Returns host cycle counter (TSC) or nanoseconds where not available.
+ */
+uint64_t sim_cycles(void);
+
+/**
+ * sim_advance
+ *
+ * Advances simulated time by ticks, runs due timers and pended functions.
+ */
+void sim_advance(TickType_t ticks);
+
+/**
+ * sim_run_tasks
+ *
+ * Runs created tasks (cooperatively, own stack each) until every one of
+ * them blocks. Blocked task is resumed by next call, it rechecks its wait
+ * condition and timeout. Call where the tasks would preempt main, e.g.
+ * after interrupt.
+ */
+void sim_run_tasks(void);
+
+/**
+ * sim_ctl
+ *
+ * Runs control transfer through registered callback set of request type
+ * (bm bits 6:5): setup callback, data stage (copy from out or to in) and
+ * status stage (ack callback). Returns number of data stage bytes or -1 on
+ * STALL. Transfer is recorded in sim_last.
+ */
+int sim_ctl(uint8_t bm, uint8_t req, uint16_t val, uint16_t idx, uint16_t len,
+	    const void *out, void *in);
+
+/**
+ * sim_stp_cycles
+ *
+ * Calls setup callback of request type (bm bits 6:5) rounds times with the
+ * same setup packet, no data and status stage. Returns total cycles.
+ */
+uint64_t sim_stp_cycles(uint8_t bm, uint8_t req, uint16_t val, uint16_t idx, uint16_t len,
+			int rounds);
+
+/**
+ * sim_get_desc
+ */
+int sim_get_desc(int recp, uint8_t type, uint8_t idx, uint16_t w_index, uint16_t len, void *in);
+
+/**
+ * sim_bus_reset
+ *
+ * Resets device state (default state, address 0, endpoints disabled) and
+ * posts state event to UDP event queue.
+ */
+void sim_bus_reset(void);
+
+/**
+ * sim_suspend
+ */
+void sim_suspend(void);
+
+/**
+ * sim_udp_evnt_que
+ */
+QueueHandle_t sim_udp_evnt_que(void);
+
+/**
+ * sim_logger_que_bytes
+ *
+ * Returns storage size of logger queue passed to init_udp(), 0 without log.
+ */
+size_t sim_logger_que_bytes(void);
+
+/**
+ * sim_udp_addr
+ */
+int sim_udp_addr(void);
+
+/**
+ * sim_endp_que_ready
+ *
+ * Returns TRUE if init_udp_endp_que() was called for endpoint ep.
+ */
+boolean_t sim_endp_que_ready(int ep);
+
+/**
+ * sim_reset_ctl_stats
+ */
+void sim_reset_ctl_stats(void);
+
+/**
+ * sim_msg_text
+ *
+ * Returns text captured from msg() since last sim_msg_clear().
+ */
+const char *sim_msg_text(void);
+
+/**
+ * sim_msg_clear
+ */
+void sim_msg_clear(void);
+
+/**
+ * sim_check
+ */
+void sim_check(int ok, const char *expr, const char *file, int line);
+
+#define SIM_CHECK(cond) sim_check((cond) != 0, #cond, __FILE__, __LINE__)
+
+/**
+ * sim_result
+ *
+ * Prints test result, returns process exit status.
+ */
+int sim_result(const char *nm);
+
+#endif
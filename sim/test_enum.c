@@ -0,0 +1,373 @@
+/*
+ * test_enum.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Linux style enumeration of the mouse and keyboard configuration, then
+ * HID class requests and request errors.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_hid_def.h"
+#include "usb_ctl_req.h"
+#include "usb_log.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define RCP_DEV 0
+#define RCP_IFC 1
+#define CLS_IFC_IN 0xA1
+#define CLS_IFC_OUT 0x21
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+#if USB_JIG_KEYB_IFACE == 1
+static int led_ticks;
+#endif
+
+static void bus_reset(void);
+static void enumerate(void);
+static void check_hid_reqs(void);
+static void check_req_errs(void);
+static void check_idle_dflts(void);
+static void check_idle_reset(void);
+static void check_idle_restart(void);
+#if USB_JIG_KEYB_IFACE == 1
+static void led_hook(void);
+static void check_led_wait(void);
+#endif
+static void check_enum_tm(void);
+static void drain_log(void);
+
+/**
+ * bus_reset
+ */
+static void bus_reset(void)
+{
+	QueueSetMemberHandle_t m;
+	enum udp_state st;
+
+	sim_bus_reset();
+	note_usb_jiggler_bus_reset();
+	// Control task side, state events are consumed.
+	while ((m = xQueueSelectFromSet(jig_ctl_qset, 0))) {
+		xQueueReceive(m, &st, 0);
+	}
+}
+
+/**
+ * enumerate
+ */
+static void enumerate(void)
+{
+	struct usb_dev_desc dd;
+	struct usb_conf_desc cd;
+	const uint8_t *p;
+	int n, eps = 0;
+
+	bus_reset();
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_DEV_DESC, 0, 0, 64, buf) == sizeof(struct usb_dev_desc));
+	SIM_CHECK(sim_last.ucr.trans_dir == UDP_CTL_TRANS_IN && sim_last.ucr.trans_nmb == 64);
+	memcpy(&dd, buf, sizeof(dd));
+	SIM_CHECK(dd.type == USB_DEV_DESC && dd.b_max_packet_size0 == 64);
+	SIM_CHECK(dd.id_vendor == USB_JIG_VENDORID && dd.id_product == USB_JIG_PRODUCTID);
+	bus_reset();
+	SIM_CHECK(sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(sim_last.ucr.trans_dir == UDP_CTL_TRANS_OUT);
+	SIM_CHECK(sim_udp_addr() == 5 && get_udp_state() == UDP_STATE_ADDRESSED);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_DEV_DESC, 0, 0, 18, buf) == 18);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_CONF_DESC, 0, 0, 9, buf) == 9);
+	memcpy(&cd, buf, sizeof(cd));
+	SIM_CHECK(cd.b_num_interfaces == USB_JIG_KEYB_IFACE + 1);
+	n = sim_get_desc(RCP_DEV, USB_CONF_DESC, 0, 0, cd.w_total_size, buf);
+	SIM_CHECK(n == cd.w_total_size);
+	for (p = buf; p < buf + n && p[0]; p += p[0]) {
+		if (p[1] == USB_ENDP_DESC) {
+			SIM_CHECK(p[2] == (0x80 | (eps ? USB_JIG_IN_K_ENDP_NUM : USB_JIG_IN_M_ENDP_NUM)));
+			eps++;
+		}
+	}
+	SIM_CHECK(eps == USB_JIG_KEYB_IFACE + 1);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 0, 0, 255, buf) == 4);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 2, 0x0409, 255, buf) == 24);
+	SIM_CHECK(buf[2] == 'S' && buf[4] == 'A' && buf[22] == 'R');
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 1, 0x0409, 255, buf) > 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 3, 0x0409, 255, buf) > 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 4, 0x0409, 255, buf) < 0);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(get_udp_state() == UDP_STATE_CONFIGURED);
+	SIM_CHECK(is_udp_endp_enabled(USB_JIG_IN_M_ENDP_NUM));
+#if USB_JIG_KEYB_IFACE == 1
+	SIM_CHECK(is_udp_endp_enabled(USB_JIG_IN_K_ENDP_NUM));
+#endif
+}
+
+/**
+ * check_hid_reqs
+ */
+static void check_hid_reqs(void)
+{
+	struct mouse_report mr = {.bm = 1, .x = 5, .y = -3};
+#if USB_JIG_KEYB_IFACE == 1
+	struct keyb_led_report lr;
+	uint8_t leds = 0x02;
+	uint32_t seq = 0;
+#endif
+	int i;
+
+	for (i = 0; i <= USB_JIG_KEYB_IFACE; i++) {
+		SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_IDLE, 0, i, 0, NULL, NULL) == 0);
+		SIM_CHECK(sim_get_desc(RCP_IFC, USB_HID_REPORT_DESC, 0, i, 255, buf) > 0);
+		SIM_CHECK(buf[0] == 0x05 && buf[1] == 0x01);
+	}
+	publish_hid_report(USB_JIG_M_IFACE, &mr);
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8, USB_JIG_M_IFACE,
+			  64, NULL, buf) == sizeof(mr));
+	SIM_CHECK(!memcmp(buf, &mr, sizeof(mr)));
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_IDLE, 0, USB_JIG_M_IFACE, 1, NULL, buf) == 1);
+	SIM_CHECK(buf[0] == 0);
+#if USB_JIG_KEYB_IFACE == 1
+	SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_REPORT, USB_HID_REPORT_OUT << 8, USB_JIG_K_IFACE,
+			  1, &leds, NULL) == 1);
+	SIM_CHECK(get_keyb_led_report(&lr, &seq) == 1 && lr.leds == 0x02);
+#endif
+}
+
+/**
+ * check_req_errs
+ */
+static void check_req_errs(void)
+{
+	struct usb_jiggler_stats st;
+
+	get_usb_jiggler_stats(&st);
+	SIM_CHECK(st.stp_err_cnt == 1);
+	// Reserved request code, interface recipient of device request.
+	SIM_CHECK(sim_ctl(0x80, 2, 0, 0, 2, NULL, buf) < 0);
+	SIM_CHECK(sim_ctl(0x01, USB_SET_ADDRESS, 1, 0, 0, NULL, NULL) < 0);
+	SIM_CHECK(sim_ctl(0xA1, 0x55, 0, 0, 8, NULL, buf) < 0);
+	SIM_CHECK(sim_ctl(0x40, 0x55, 0, 0, 0, NULL, NULL) < 0);
+	get_usb_jiggler_stats(&st);
+	SIM_CHECK(st.stp_err_cnt == 5);
+	SIM_CHECK(st.std_req_cnt[USB_GET_DESCRIPTOR][USB_JIG_REQ_DONE] > 0);
+	SIM_CHECK(st.std_req_cnt[USB_SET_ADDRESS][USB_JIG_REQ_ERR] == 1);
+	SIM_CHECK(sim_ctl_stats.proto_errs == 0);
+}
+
+/**
+ * check_idle_dflts
+ */
+static void check_idle_dflts(void)
+{
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_IDLE, 0, USB_JIG_M_IFACE, 1, NULL, buf) == 1);
+	SIM_CHECK(buf[0] == 0);
+#if USB_JIG_KEYB_IFACE == 1
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_IDLE, 0, USB_JIG_K_IFACE, 1, NULL, buf) == 1);
+	SIM_CHECK(buf[0] == 500 / 4);
+#endif
+}
+
+/**
+ * check_idle_reset
+ *
+ * Idle rates set by host return to defaults on SET_CONFIGURATION and bus
+ * reset.
+ */
+static void check_idle_reset(void)
+{
+	int i;
+
+	for (i = 0; i <= USB_JIG_KEYB_IFACE; i++) {
+		SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_IDLE, 0x20 << 8, i, 0, NULL, NULL) == 0);
+	}
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_IDLE, 0, USB_JIG_M_IFACE, 1, NULL, buf) == 1);
+	SIM_CHECK(buf[0] == 0x20);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	check_idle_dflts();
+	for (i = 0; i <= USB_JIG_KEYB_IFACE; i++) {
+		SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_IDLE, 0x20 << 8, i, 0, NULL, NULL) == 0);
+	}
+	enumerate();
+	check_idle_dflts();
+}
+
+/**
+ * check_idle_restart
+ *
+ * New idle rate restarts idle period at SET_IDLE, or makes report due at
+ * once if new period already passed since last report.
+ */
+static void check_idle_restart(void)
+{
+	SIM_CHECK(is_hid_report_due(USB_JIG_M_IFACE, TRUE));
+	sim_advance(150);
+	SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_IDLE, (200 / 4) << 8, USB_JIG_M_IFACE, 0,
+			  NULL, NULL) == 0);
+	sim_advance(100);
+	// 251 ms since last report, 100 ms since SET_IDLE.
+	SIM_CHECK(!is_hid_report_due(USB_JIG_M_IFACE, FALSE));
+	sim_advance(100);
+	SIM_CHECK(is_hid_report_due(USB_JIG_M_IFACE, FALSE));
+	sim_advance(150);
+	SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_IDLE, (100 / 4) << 8, USB_JIG_M_IFACE, 0,
+			  NULL, NULL) == 0);
+	SIM_CHECK(is_hid_report_due(USB_JIG_M_IFACE, FALSE));
+	SIM_CHECK(!is_hid_report_due(USB_JIG_M_IFACE, FALSE));
+	SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_IDLE, 0, USB_JIG_M_IFACE, 0, NULL, NULL) == 0);
+	sim_advance(1000);
+	SIM_CHECK(!is_hid_report_due(USB_JIG_M_IFACE, FALSE));
+}
+
+#if USB_JIG_KEYB_IFACE == 1
+/**
+ * led_hook
+ *
+ * Host sends LED report led_ticks ticks after wait started.
+ */
+static void led_hook(void)
+{
+	uint8_t leds = 0x01;
+
+	if (--led_ticks == 0) {
+		SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_REPORT, USB_HID_REPORT_OUT << 8,
+				  USB_JIG_K_IFACE, 1, &leds, NULL) == 1);
+	}
+}
+
+/**
+ * check_led_wait
+ *
+ * wait_keyb_led_report() returns report already received at once, blocks
+ * until next one or timeout.
+ */
+static void check_led_wait(void)
+{
+	struct keyb_led_report lr;
+	uint32_t seq = 0;
+	uint8_t leds = 0x04;
+	TickType_t t;
+
+	SIM_CHECK(sim_ctl(CLS_IFC_OUT, USB_HID_SET_REPORT, USB_HID_REPORT_OUT << 8, USB_JIG_K_IFACE,
+			  1, &leds, NULL) == 1);
+	t = xTaskGetTickCount();
+	SIM_CHECK(wait_keyb_led_report(&lr, &seq, 10) > 0 && lr.leds == 0x04);
+	SIM_CHECK(xTaskGetTickCount() == t);
+	SIM_CHECK(wait_keyb_led_report(&lr, &seq, 10) == 0);
+	SIM_CHECK(xTaskGetTickCount() - t == 10);
+	led_ticks = 3;
+	sim_block_hook = led_hook;
+	t = xTaskGetTickCount();
+	SIM_CHECK(wait_keyb_led_report(&lr, &seq, 10) == 1 && lr.leds == 0x01);
+	SIM_CHECK(xTaskGetTickCount() - t <= 4);
+	sim_block_hook = NULL;
+}
+#endif
+
+/**
+ * check_enum_tm
+ *
+ * enum_tm is time from bus reset to first non zero SET_CONFIGURATION,
+ * later (re)configurations keep it.
+ */
+static void check_enum_tm(void)
+{
+	struct usb_jiggler_stats st;
+	uint32_t tm;
+
+	get_usb_jiggler_stats(&st);
+	tm = st.enum_tm;
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 0, 0, 0, NULL, NULL) == 0);
+	sim_advance(5);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	get_usb_jiggler_stats(&st);
+	SIM_CHECK(st.enum_tm == tm);
+	bus_reset();
+	sim_advance(3);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 0, 0, 0, NULL, NULL) == 0);
+	get_usb_jiggler_stats(&st);
+	SIM_CHECK(st.enum_tm == tm);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	get_usb_jiggler_stats(&st);
+	SIM_CHECK(st.enum_tm == 6);
+}
+
+/**
+ * drain_log
+ */
+static void drain_log(void)
+{
+#if SIM_LOG == 1
+	int i;
+
+	for (i = 0; i < USB_LOG_EVENTS_QUEUE_SIZE; i++) {
+		run_usb_log_drain();
+	}
+#endif
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+#if USB_JIG_TMLN == 1
+	const struct usb_jig_tmln_item *tl;
+	int i, n;
+#endif
+	struct usb_jiggler_stats st;
+
+	init_usb_jiggler();
+	SIM_CHECK(sim_endp_que_ready(USB_JIG_IN_M_ENDP_NUM));
+	SIM_CHECK(sim_endp_que_ready(USB_JIG_IN_K_ENDP_NUM) == USB_JIG_KEYB_IFACE);
+	enumerate();
+	drain_log();
+	SIM_CHECK(strstr(sim_msg_text(), "std[get_desc]") != NULL);
+	SIM_CHECK(strstr(sim_msg_text(), "[set_conf]=done") != NULL);
+	check_idle_dflts();
+	check_hid_reqs();
+	check_req_errs();
+	get_usb_jiggler_stats(&st);
+	SIM_CHECK(st.bus_rst_cnt == 2 && st.enum_tm > 0);
+	printf("test_enum: %u transfers, %u stalls, %u packets, enum_tm %u ms\n",
+	       sim_ctl_stats.xfers, sim_ctl_stats.stalls, sim_ctl_stats.pkts, (unsigned int) st.enum_tm);
+#if USB_JIG_TMLN == 1
+	tl = get_usb_jiggler_tmln(&n);
+	SIM_CHECK(n > 2 && tl[0].evnt == USB_JIG_TMLN_BUS_RST);
+	for (i = 0; i < n; i++) {
+		if (tl[i].evnt == USB_JIG_TMLN_SET_CONF) {
+			printf("test_enum: time to configured %u ms\n", (unsigned int) (tl[i].ts - tl[0].ts));
+			break;
+		}
+	}
+	SIM_CHECK(i < n);
+#endif
+	check_idle_reset();
+	check_idle_restart();
+#if USB_JIG_KEYB_IFACE == 1
+	check_led_wait();
+#endif
+	check_enum_tm();
+	return (sim_result("test_enum"));
+}
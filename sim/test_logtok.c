@@ -0,0 +1,137 @@
+/*
+ * test_logtok.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Tokenized log: enumeration with setup and command events and timeline,
+ * every token printed by the library must render with the host dictionary
+ * (logtok_dec.c) to the same fields, malformed tokens are refused.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_log.h"
+#include "usb_jiggler.h"
+#include "logtok_dec.h"
+#include "sim.h"
+
+#define TAG "usb_jiggler.c: @"
+#define RND_SIZE 8192
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+static char rnd[RND_SIZE];
+
+static void enumerate(void);
+static int render_all(int *tok_len);
+static void check_dec(void);
+
+/**
+ * enumerate
+ */
+static void enumerate(void)
+{
+	int i;
+
+	sim_bus_reset();
+	note_usb_jiggler_bus_reset();
+	SIM_CHECK(sim_get_desc(0, USB_DEV_DESC, 0, 0, 18, buf) == 18);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	for (i = 0; i < USB_LOG_EVENTS_QUEUE_SIZE; i++) {
+		run_usb_log_drain();
+	}
+	log_usb_jiggler_stats();
+}
+
+/**
+ * render_all
+ *
+ * Renders token lines of captured log into rnd, returns number of tokens
+ * (-1 if one fails) and total length of token lines in tok_len.
+ */
+static int render_all(int *tok_len)
+{
+	const char *p, *e;
+	int n = 0, len = 0, r;
+
+	*tok_len = 0;
+	for (p = sim_msg_text(); (p = strstr(p, TAG)); p = e) {
+		p += strlen(TAG);
+		if (!(e = strchr(p, '\n'))) {
+			return (-1);
+		}
+		*tok_len += strlen(TAG) + (e - p);
+		if ((r = render_log_tok(p, rnd + len, RND_SIZE - len - 1)) < 0) {
+			return (-1);
+		}
+		len += r;
+		rnd[len++] = '\n';
+		n++;
+	}
+	rnd[len] = '\0';
+	return (n);
+}
+
+/**
+ * check_dec
+ */
+static void check_dec(void)
+{
+	char txt[64];
+
+	// stp_err=300, 300 is AC 02.
+	SIM_CHECK(render_log_tok("02AC02", txt, sizeof(txt)) > 0);
+	SIM_CHECK(!strcmp(txt, "stp_err=300"));
+	SIM_CHECK(render_log_tok("04FFFFFFFF0F010280FF03\n", txt, sizeof(txt)) > 0);
+	SIM_CHECK(!strcmp(txt, "tmln +4294967295 evnt=1 req=2 val=0xFF80"));
+	// Command result 3 is dev_qual_desc unsupported, 6 is out of list.
+	SIM_CHECK(render_log_tok("010006030000", txt, sizeof(txt)) > 0);
+	SIM_CHECK(!strcmp(txt, "[type=0 req=6]=dev_qual_desc unsupported +0 q0"));
+	SIM_CHECK(render_log_tok("010006060000", txt, sizeof(txt)) < 0);
+	SIM_CHECK(render_log_tok("02AC", txt, sizeof(txt)) < 0);
+	SIM_CHECK(render_log_tok("02", txt, sizeof(txt)) < 0);
+	SIM_CHECK(render_log_tok("020102", txt, sizeof(txt)) < 0);
+	SIM_CHECK(render_log_tok("7F01", txt, sizeof(txt)) < 0);
+	SIM_CHECK(render_log_tok("02AC02", txt, 5) < 0);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	int n, tok_len;
+
+	init_usb_jiggler();
+	enumerate();
+	SIM_CHECK(strstr(sim_msg_text(), "std[") == NULL);
+	SIM_CHECK((n = render_all(&tok_len)) > 0);
+	SIM_CHECK(strstr(rnd, "stp type=0x80 req=6 val=0x0100 ind=0x0000 len=18 +0 q0\n") != NULL);
+	SIM_CHECK(strstr(rnd, "stp type=0x00 req=9 val=0x0001 ind=0x0000 len=0") != NULL);
+	SIM_CHECK(strstr(rnd, "[type=0 req=9]=done +0 q0\n") != NULL);
+	SIM_CHECK(strstr(rnd, "tmln +0 evnt=0 req=0 val=0x0000\n") != NULL);
+	check_dec();
+	printf("test_logtok: %d messages, %d token chars, %d rendered chars\n", n, tok_len,
+	       (int) strlen(rnd) - n);
+	return (sim_result("test_logtok"));
+}
@@ -0,0 +1,150 @@
+/*
+ * test_motion.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Motion accumulator: pseudo random moves (up to several report ranges)
+ * and button edges are added between host polls, total displacement of the
+ * reports must equal the added motion, every delta must fit report range
+ * and button states must come in the order they were set.
+ */
+
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_motion.h"
+#include "sim.h"
+
+#define ROUNDS 20000
+#define BM_SEQ_SIZE (ROUNDS + 1)
+
+static uint32_t rnd_state = 12345;
+static uint8_t set_seq[BM_SEQ_SIZE], rep_seq[BM_SEQ_SIZE];
+static int set_nmb, rep_nmb;
+static long sum_x, sum_y, sum_w;
+static int rep_cnt, range_errs;
+
+static int rnd(int n);
+static void poll(void);
+static void check_split(void);
+
+/**
+ * rnd
+ */
+static int rnd(int n)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return ((rnd_state >> 8) % n);
+}
+
+/**
+ * poll
+ */
+static void poll(void)
+{
+	struct mouse_report rep;
+
+	if (!get_mouse_motion_report(&rep)) {
+		return;
+	}
+	rep_cnt++;
+	if (rep.x < -127 || rep.y < -127 || rep.w < -127) {
+		range_errs++;
+	}
+	sum_x += rep.x;
+	sum_y += rep.y;
+	sum_w += rep.w;
+	if (rep.bm != rep_seq[rep_nmb - 1] && rep_nmb < BM_SEQ_SIZE) {
+		rep_seq[rep_nmb++] = rep.bm;
+	}
+}
+
+/**
+ * check_split
+ *
+ * Single large move is reported in the least number of full range reports.
+ */
+static void check_split(void)
+{
+	struct mouse_report rep;
+	int n = 0;
+
+	add_mouse_motion(1000, -300, 0);
+	while (get_mouse_motion_report(&rep)) {
+		SIM_CHECK(n < 7 ? rep.x == 127 : rep.x == 1000 - 7 * 127);
+		n++;
+	}
+	SIM_CHECK(n == 8);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	long add_x = 0, add_y = 0, add_w = 0;
+	int i, dx, dy, dw, full = 0;
+	uint8_t bm;
+
+	init_usb_jiggler();
+	check_split();
+	set_seq[set_nmb++] = 0;
+	rep_seq[rep_nmb++] = 0;
+	for (i = 0; i < ROUNDS; i++) {
+		dx = rnd(801) - 400;
+		dy = rnd(201) - 100;
+		dw = rnd(4) ? 0 : rnd(11) - 5;
+		add_mouse_motion(dx, dy, dw);
+		add_x += dx;
+		add_y += dy;
+		add_w += dw;
+		if (!rnd(8)) {
+			bm = rnd(8);
+			if (bm != set_seq[set_nmb - 1]) {
+				if (set_mouse_buttons(bm)) {
+					set_seq[set_nmb++] = bm;
+				} else {
+					full++;
+				}
+			}
+		}
+		// Host polls less often than the application adds motion.
+		if (rnd(3)) {
+			poll();
+		}
+	}
+	for (i = 0; i < ROUNDS; i++) {
+		poll();
+	}
+	SIM_CHECK(sum_x == add_x && sum_y == add_y && sum_w == add_w);
+	SIM_CHECK(range_errs == 0);
+	SIM_CHECK(rep_nmb == set_nmb);
+	for (i = 0; i < set_nmb && i < rep_nmb; i++) {
+		if (rep_seq[i] != set_seq[i]) {
+			break;
+		}
+	}
+	SIM_CHECK(i == set_nmb);
+	printf("test_motion: %ld/%ld/%ld displacement in %d reports, %d edges, %d edges refused\n",
+	       sum_x, sum_y, sum_w, rep_cnt, set_nmb - 1, full);
+	return (sim_result("test_motion"));
+}
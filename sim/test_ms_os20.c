@@ -0,0 +1,108 @@
+/*
+ * test_ms_os20.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Replay of Windows 8.1+ enumeration probe of USB 2.1 device: BOS
+ * descriptor read in two steps, MS OS 2.0 descriptor set read with vendor
+ * code from platform capability, MS OS 1.0 string and other MS OS 2.0
+ * indexes stalled.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define RCP_DEV 0
+#define BOS_DESC 0x0F
+#define MS_OS_10_STR_IDX 0xEE
+#define MS_OS_20_DESC_INDEX 7
+#define MS_OS_20_SET_ALT_ENUM 8
+#define MS_OS_20_CAP_OFFS 12
+
+static const uint8_t ms_os_20_uuid[] = {
+	0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,
+	0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F
+};
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+
+static uint16_t get_le16(const uint8_t *p);
+
+/**
+ * get_le16
+ */
+static uint16_t get_le16(const uint8_t *p)
+{
+	return (p[0] | p[1] << 8);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	const uint8_t *cap;
+	uint16_t bos_size, set_size;
+	uint8_t vnd_code;
+
+	init_usb_jiggler();
+	sim_bus_reset();
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_DEV_DESC, 0, 0, 64, buf) == 18);
+	sim_bus_reset();
+	SIM_CHECK(sim_ctl(0x00, USB_SET_ADDRESS, 3, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_DEV_DESC, 0, 0, 18, buf) == 18);
+	// bcdUSB 2.01 or higher makes Windows read BOS descriptor, device reports 2.1.
+	SIM_CHECK(get_le16(buf + 2) == 0x0210);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_CONF_DESC, 0, 0, 255, buf) > 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, BOS_DESC, 0, 0, 5, buf) == 5);
+	SIM_CHECK(buf[0] == 5 && buf[1] == BOS_DESC && buf[4] == 2);
+	bos_size = get_le16(buf + 2);
+	SIM_CHECK(sim_get_desc(RCP_DEV, BOS_DESC, 0, 0, bos_size, buf) == bos_size);
+	cap = buf + MS_OS_20_CAP_OFFS;
+	SIM_CHECK(cap[0] == 28 && cap[1] == 0x10 && cap[2] == 0x05);
+	SIM_CHECK(!memcmp(cap + 4, ms_os_20_uuid, sizeof(ms_os_20_uuid)));
+	SIM_CHECK(get_le16(cap + 20) == 0x0000 && get_le16(cap + 22) == 0x0603);
+	set_size = get_le16(cap + 24);
+	vnd_code = cap[26];
+	SIM_CHECK(vnd_code == USB_JIG_MS_OS_20_VENDOR_CODE);
+	// MS OS 2.0 descriptor set, header only.
+	SIM_CHECK(sim_ctl(0xC0, vnd_code, 0, MS_OS_20_DESC_INDEX, set_size, NULL, buf) == set_size);
+	SIM_CHECK(get_le16(buf) == 10 && get_le16(buf + 2) == 0x0000);
+	SIM_CHECK(get_le16(buf + 4) == 0x0000 && get_le16(buf + 6) == 0x0603);
+	SIM_CHECK(get_le16(buf + 8) == set_size);
+	// Alternate enumeration is not supported (bAltEnumCode 0).
+	SIM_CHECK(cap[27] == 0);
+	SIM_CHECK(sim_ctl(0x40, vnd_code, 0, MS_OS_20_SET_ALT_ENUM, 0, NULL, NULL) < 0);
+	SIM_CHECK(sim_ctl(0xC0, vnd_code, 0, 4, 16, NULL, buf) < 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, MS_OS_10_STR_IDX, 0, 18, buf) < 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_DEV_QUAL_DESC, 0, 0, 10, buf) < 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 0, 0, 255, buf) == 4);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_STR_DESC, 2, 0x0409, 255, buf) > 0);
+	SIM_CHECK(sim_get_desc(RCP_DEV, USB_CONF_DESC, 0, 0, 9, buf) == 9);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	SIM_CHECK(get_udp_state() == UDP_STATE_CONFIGURED);
+	SIM_CHECK(sim_ctl_stats.proto_errs == 0);
+	return (sim_result("test_ms_os20"));
+}
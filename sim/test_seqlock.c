@@ -0,0 +1,220 @@
+/*
+ * test_seqlock.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Report store stress test. Main thread is the writer task, it publishes
+ * reports of both interfaces filled from a write counter (24 bit counter
+ * and check bytes derived from it).
+ * Reader threads run read_hid_report() concurrently (on other cores) and
+ * interval timer signal preempts the writer like USB interrupt and runs
+ * GET_REPORT through the control pipe. Every report seen must be one of
+ * the written ones and counters must not go back.
+ *
+ * Library barriers are compiler only (single core target), the concurrent
+ * readers rely on x86 store and load ordering.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_hid_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define WRITES 1000000
+#define READER_NMB 2
+#define TMR_US 20
+#define REP_MAX_SIZE 32
+
+static const int rep_size[] = {
+	sizeof(struct mouse_report),
+#if USB_JIG_KEYB_IFACE == 1
+	sizeof(struct keyb_report)
+#endif
+};
+
+#define IFACE_NMB (int) (sizeof(rep_size) / sizeof(rep_size[0]))
+
+static volatile int done;
+static volatile unsigned int isr_reads, isr_torn, isr_back;
+static unsigned int rd_reads[READER_NMB], rd_torn[READER_NMB], rd_back[READER_NMB];
+
+static uint8_t chk_byte(uint32_t cnt, int i);
+static void fill_rep(uint8_t *rep, int size, uint32_t cnt);
+static boolean_t check_rep(const uint8_t *rep, int size, uint32_t *last);
+static void *reader(void *arg);
+static void intr(int sig);
+
+/**
+ * chk_byte
+ */
+static uint8_t chk_byte(uint32_t cnt, int i)
+{
+	cnt = (cnt + i) * 2654435761u;
+	return (cnt >> 24);
+}
+
+/**
+ * fill_rep
+ */
+static void fill_rep(uint8_t *rep, int size, uint32_t cnt)
+{
+	int i;
+
+	rep[0] = cnt;
+	rep[1] = cnt >> 8;
+	rep[2] = cnt >> 16;
+	for (i = 3; i < size; i++) {
+		rep[i] = chk_byte(cnt, i);
+	}
+}
+
+/**
+ * check_rep
+ *
+ * Returns TRUE if rep is consistent, sets *last to its counter.
+ */
+static boolean_t check_rep(const uint8_t *rep, int size, uint32_t *last)
+{
+	uint32_t cnt;
+	int i;
+
+	cnt = rep[0] | rep[1] << 8 | rep[2] << 16;
+	for (i = 3; i < size; i++) {
+		if (rep[i] != chk_byte(cnt, i)) {
+			return (FALSE);
+		}
+	}
+	*last = cnt;
+	return (TRUE);
+}
+
+/**
+ * reader
+ */
+static void *reader(void *arg)
+{
+	int n = (int) (intptr_t) arg, i;
+	uint8_t rep[REP_MAX_SIZE];
+	uint32_t last[IFACE_NMB] = {0}, prev;
+
+	while (!done) {
+		for (i = 0; i < IFACE_NMB; i++) {
+			read_hid_report(i, rep);
+			rd_reads[n]++;
+			prev = last[i];
+			if (!check_rep(rep, rep_size[i], &last[i])) {
+				rd_torn[n]++;
+			} else if (last[i] < prev) {
+				rd_back[n]++;
+			}
+		}
+	}
+	return (NULL);
+}
+
+/**
+ * intr
+ */
+static void intr(int sig)
+{
+	static uint32_t last[IFACE_NMB];
+	uint8_t rep[SIM_XFER_DATA_SIZE];
+	uint32_t prev;
+	int i;
+
+	for (i = 0; i < IFACE_NMB; i++) {
+		if (sim_ctl(0xA1, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8, i, REP_MAX_SIZE, NULL,
+			    rep) != rep_size[i]) {
+			isr_torn++;
+			continue;
+		}
+		isr_reads++;
+		prev = last[i];
+		if (!check_rep(rep, rep_size[i], &last[i])) {
+			isr_torn++;
+		} else if (last[i] < prev) {
+			isr_back++;
+		}
+	}
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	pthread_t th[READER_NMB];
+	struct itimerval itv = {{0, TMR_US}, {0, TMR_US}};
+	uint8_t rep[REP_MAX_SIZE];
+	uint32_t last;
+	unsigned int reads = 0, torn = 0, back = 0;
+	sigset_t ss;
+	int i, w;
+
+	init_usb_jiggler();
+	sim_bus_reset();
+	sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL);
+	SIM_CHECK(sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL) == 0);
+	for (i = 0; i < IFACE_NMB; i++) {
+		fill_rep(rep, rep_size[i], 0);
+		publish_hid_report(i, rep);
+	}
+	// Readers must not take the timer signal.
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &ss, NULL);
+	for (i = 0; i < READER_NMB; i++) {
+		pthread_create(&th[i], NULL, reader, (void *) (intptr_t) i);
+	}
+	pthread_sigmask(SIG_UNBLOCK, &ss, NULL);
+	signal(SIGALRM, intr);
+	setitimer(ITIMER_REAL, &itv, NULL);
+	for (w = 1; w <= WRITES; w++) {
+		for (i = 0; i < IFACE_NMB; i++) {
+			fill_rep(rep, rep_size[i], w);
+			publish_hid_report(i, rep);
+		}
+	}
+	memset(&itv, 0, sizeof(itv));
+	setitimer(ITIMER_REAL, &itv, NULL);
+	done = 1;
+	for (i = 0; i < READER_NMB; i++) {
+		pthread_join(th[i], NULL);
+		reads += rd_reads[i];
+		torn += rd_torn[i];
+		back += rd_back[i];
+	}
+	SIM_CHECK(reads > 0 && torn == 0 && back == 0);
+	SIM_CHECK(isr_reads > 0 && isr_torn == 0 && isr_back == 0);
+	for (i = 0; i < IFACE_NMB; i++) {
+		read_hid_report(i, rep);
+		SIM_CHECK(check_rep(rep, rep_size[i], &last) && last == WRITES);
+	}
+	printf("test_seqlock: %d writes, %u reader reads, %u interrupt reads, %u torn, %u stale\n",
+	       WRITES * IFACE_NMB, reads, isr_reads, torn + isr_torn, back + isr_back);
+	return (sim_result("test_seqlock"));
+}
@@ -0,0 +1,176 @@
+/*
+ * test_stats.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Statistics feature report (USB_JIG_STATS_REP): own vendor defined top
+ * level collection, mouse input report with report ID 1 set by library on
+ * publish and take, GET_REPORT checks report ID of wValue.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_hid_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+#define RCP_IFC 1
+#define CLS_IFC_IN 0xA1
+
+static uint8_t buf[SIM_XFER_DATA_SIZE];
+
+static void configure(void);
+static int find_item(const uint8_t *desc, int size, int from, const uint8_t *item, int len);
+static void check_rep_desc(void);
+static void check_mouse_rep(void);
+static void check_stats_rep(void);
+static void check_take(void);
+
+/**
+ * configure
+ */
+static void configure(void)
+{
+	sim_bus_reset();
+	sim_ctl(0x00, USB_SET_ADDRESS, 5, 0, 0, NULL, NULL);
+	sim_ctl(0x00, USB_SET_CONFIGURATION, 1, 0, 0, NULL, NULL);
+	SIM_CHECK(get_udp_state() == UDP_STATE_CONFIGURED);
+}
+
+/**
+ * find_item
+ *
+ * Returns offset of item in desc at or after from or -1.
+ */
+static int find_item(const uint8_t *desc, int size, int from, const uint8_t *item, int len)
+{
+	int i;
+
+	for (i = from; i + len <= size; i++) {
+		if (!memcmp(desc + i, item, len)) {
+			return (i);
+		}
+	}
+	return (-1);
+}
+
+/**
+ * check_rep_desc
+ */
+static void check_rep_desc(void)
+{
+	static const uint8_t m_id[] = {0xa1, 0x01, 0x85, USB_JIG_M_REP_ID};
+	static const uint8_t vnd[] = {0x06, 0x00, 0xff, 0x09, 0x01, 0xa1, 0x01, 0x85,
+				      USB_JIG_STATS_REP_ID};
+	static const uint8_t cnt[] = {0x95, sizeof(struct usb_jig_stats_report) - 1, 0xb1, 0x02};
+	static const uint8_t end[] = {0xc0, 0xc0, 0x06};
+	int n, m, v;
+
+	n = sim_get_desc(RCP_IFC, USB_HID_REPORT_DESC, 0, USB_JIG_M_IFACE, 255, buf);
+	SIM_CHECK(n > 0);
+	m = find_item(buf, n, 0, m_id, sizeof(m_id));
+	SIM_CHECK(m == 4);
+	// Mouse collection is closed before vendor collection starts.
+	v = find_item(buf, n, 0, vnd, sizeof(vnd));
+	SIM_CHECK(v > m);
+	SIM_CHECK(find_item(buf, n, 0, end, sizeof(end)) == v - 2);
+	SIM_CHECK(find_item(buf, n, v, cnt, sizeof(cnt)) > v);
+	SIM_CHECK(buf[n - 1] == 0xc0 && buf[n - 2] != 0xc0);
+}
+
+/**
+ * check_mouse_rep
+ */
+static void check_mouse_rep(void)
+{
+	struct mouse_report mr = {.bm = 1, .x = 5, .y = -3}, rep;
+
+	SIM_CHECK(sizeof(mr) == 5);
+	publish_hid_report(USB_JIG_M_IFACE, &mr);
+	read_hid_report(USB_JIG_M_IFACE, &rep);
+	SIM_CHECK(rep.id == USB_JIG_M_REP_ID && rep.bm == 1 && rep.x == 5 && rep.y == -3);
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8 | USB_JIG_M_REP_ID,
+			  USB_JIG_M_IFACE, 64, NULL, buf) == sizeof(rep));
+	SIM_CHECK(!memcmp(buf, &rep, sizeof(rep)));
+	// Report ID of other report or none.
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8, USB_JIG_M_IFACE,
+			  64, NULL, buf) < 0);
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8 | USB_JIG_STATS_REP_ID,
+			  USB_JIG_M_IFACE, 64, NULL, buf) < 0);
+#if USB_JIG_KEYB_IFACE == 1
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8, USB_JIG_K_IFACE,
+			  64, NULL, buf) == sizeof(struct keyb_report));
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_IN << 8 | USB_JIG_M_REP_ID,
+			  USB_JIG_K_IFACE, 64, NULL, buf) < 0);
+#endif
+}
+
+/**
+ * check_stats_rep
+ */
+static void check_stats_rep(void)
+{
+	struct usb_jig_stats_report sr;
+
+	SIM_CHECK(sizeof(sr) == 72);
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_FEATURE << 8 | USB_JIG_STATS_REP_ID,
+			  USB_JIG_M_IFACE, 255, NULL, buf) == sizeof(sr));
+	memcpy(&sr, buf, sizeof(sr));
+	SIM_CHECK(sr.id == USB_JIG_STATS_REP_ID && sr.ver == USB_JIG_STATS_REP_VER);
+	SIM_CHECK(sr.req_cnt[0][USB_JIG_REQ_DONE] == 3);
+	SIM_CHECK(sr.req_cnt[1][USB_JIG_REQ_ERR] == 3);
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_FEATURE << 8,
+			  USB_JIG_M_IFACE, 255, NULL, buf) < 0);
+	SIM_CHECK(sim_ctl(CLS_IFC_IN, USB_HID_GET_REPORT, USB_HID_REPORT_FEATURE << 8 | USB_JIG_M_REP_ID,
+			  USB_JIG_M_IFACE, 255, NULL, buf) < 0);
+}
+
+/**
+ * check_take
+ */
+static void check_take(void)
+{
+	struct mouse_report mr = {.x = 7}, rep;
+
+	SIM_CHECK(submit_hid_report(USB_JIG_M_IFACE, &mr, 0));
+	SIM_CHECK(take_hid_report(USB_JIG_M_IFACE, &rep, 0));
+	SIM_CHECK(rep.id == USB_JIG_M_REP_ID && rep.x == 7);
+	complete_hid_report(USB_JIG_M_IFACE);
+	read_hid_report(USB_JIG_M_IFACE, &rep);
+	SIM_CHECK(rep.id == USB_JIG_M_REP_ID && rep.x == 7);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	init_usb_jiggler();
+	configure();
+	check_rep_desc();
+	check_mouse_rep();
+	check_stats_rep();
+	check_take();
+	return (sim_result("test_stats"));
+}
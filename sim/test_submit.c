@@ -0,0 +1,219 @@
+/*
+ * test_submit.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Report submit queue: take_hid_report() must block (not fail at once)
+ * while previous report is in flight, return it as soon as
+ * complete_hid_report() is called and keep tmo as total time of both
+ * waits. Bus reset ends in flight state.
+ */
+
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "udp.h"
+#include "usb_std_def.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "sim.h"
+
+static int done_ticks, done_cnt;
+static TickType_t done_at;
+
+static void complete_hook(void);
+static void done_clbk(int iface, void *arg);
+static struct mouse_report mk_rep(int n);
+static boolean_t same_rep(const struct mouse_report *a, const struct mouse_report *b);
+static uint32_t sent_cnt(void);
+static void check_take(void);
+static void check_blocking(void);
+static void check_total_tmo(void);
+static void check_bus_reset(void);
+
+/**
+ * complete_hook
+ *
+ * Writer side endpoint completion, done_ticks ticks after block started.
+ */
+static void complete_hook(void)
+{
+	if (--done_ticks == 0) {
+		done_at = xTaskGetTickCount();
+		complete_hid_report(USB_JIG_M_IFACE);
+	}
+}
+
+/**
+ * done_clbk
+ */
+static void done_clbk(int iface, void *arg)
+{
+	SIM_CHECK(iface == USB_JIG_M_IFACE);
+	SIM_CHECK(arg == &done_cnt);
+	done_cnt++;
+}
+
+/**
+ * mk_rep
+ */
+static struct mouse_report mk_rep(int n)
+{
+	struct mouse_report rep = {0, 0, 0, 0};
+
+	rep.x = n;
+	rep.y = -n;
+	return (rep);
+}
+
+/**
+ * same_rep
+ */
+static boolean_t same_rep(const struct mouse_report *a, const struct mouse_report *b)
+{
+	return (a->bm == b->bm && a->x == b->x && a->y == b->y && a->w == b->w);
+}
+
+/**
+ * sent_cnt
+ */
+static uint32_t sent_cnt(void)
+{
+	static struct usb_jiggler_stats st;
+
+	get_usb_jiggler_stats(&st);
+	return (st.in_rep_cnt[USB_JIG_M_IFACE]);
+}
+
+/**
+ * check_take
+ */
+static void check_take(void)
+{
+	struct mouse_report r1 = mk_rep(1), r2 = mk_rep(2), rep, pub;
+	TickType_t t;
+
+	// Empty queue, full timeout.
+	t = xTaskGetTickCount();
+	SIM_CHECK(!take_hid_report(USB_JIG_M_IFACE, &rep, 5));
+	SIM_CHECK(xTaskGetTickCount() - t == 5);
+	SIM_CHECK(!is_hid_report_in_flight(USB_JIG_M_IFACE));
+	SIM_CHECK(submit_hid_report(USB_JIG_M_IFACE, &r1, 0));
+	SIM_CHECK(submit_hid_report(USB_JIG_M_IFACE, &r2, 0));
+	SIM_CHECK(get_hid_report_pending(USB_JIG_M_IFACE) == 2);
+	t = xTaskGetTickCount();
+	SIM_CHECK(take_hid_report(USB_JIG_M_IFACE, &rep, 5));
+	SIM_CHECK(xTaskGetTickCount() == t);
+	SIM_CHECK(same_rep(&rep, &r1));
+	read_hid_report(USB_JIG_M_IFACE, &pub);
+	SIM_CHECK(same_rep(&pub, &r1));
+	SIM_CHECK(is_hid_report_in_flight(USB_JIG_M_IFACE));
+	// Previous report in flight, take must wait whole tmo.
+	SIM_CHECK(!take_hid_report(USB_JIG_M_IFACE, &rep, 10));
+	SIM_CHECK(xTaskGetTickCount() - t == 10);
+	SIM_CHECK(get_hid_report_pending(USB_JIG_M_IFACE) == 1);
+	SIM_CHECK(is_hid_report_in_flight(USB_JIG_M_IFACE));
+}
+
+/**
+ * check_blocking
+ */
+static void check_blocking(void)
+{
+	struct mouse_report r2 = mk_rep(2), rep;
+	uint32_t cnt = sent_cnt();
+	TickType_t t;
+
+	done_cnt = 0;
+	done_ticks = 3;
+	sim_block_hook = complete_hook;
+	t = xTaskGetTickCount();
+	SIM_CHECK(take_hid_report(USB_JIG_M_IFACE, &rep, 10));
+	sim_block_hook = NULL;
+	SIM_CHECK(done_at - t == 3);
+	SIM_CHECK(xTaskGetTickCount() == done_at);
+	SIM_CHECK(same_rep(&rep, &r2));
+	SIM_CHECK(done_cnt == 1);
+	SIM_CHECK(sent_cnt() == cnt + 1);
+	complete_hid_report(USB_JIG_M_IFACE);
+	SIM_CHECK(done_cnt == 2);
+	SIM_CHECK(sent_cnt() == cnt + 2);
+	SIM_CHECK(!is_hid_report_in_flight(USB_JIG_M_IFACE));
+	// Nothing in flight, no completion.
+	complete_hid_report(USB_JIG_M_IFACE);
+	SIM_CHECK(done_cnt == 2);
+	SIM_CHECK(sent_cnt() == cnt + 2);
+}
+
+/**
+ * check_total_tmo
+ *
+ * Completion after 4 ticks of 10, then queue stays empty.
+ */
+static void check_total_tmo(void)
+{
+	struct mouse_report r3 = mk_rep(3), rep;
+	TickType_t t;
+
+	SIM_CHECK(submit_hid_report(USB_JIG_M_IFACE, &r3, 0));
+	SIM_CHECK(take_hid_report(USB_JIG_M_IFACE, &rep, 0));
+	done_ticks = 4;
+	sim_block_hook = complete_hook;
+	t = xTaskGetTickCount();
+	SIM_CHECK(!take_hid_report(USB_JIG_M_IFACE, &rep, 10));
+	sim_block_hook = NULL;
+	SIM_CHECK(done_at - t == 4);
+	SIM_CHECK(xTaskGetTickCount() - t == 10);
+	SIM_CHECK(!is_hid_report_in_flight(USB_JIG_M_IFACE));
+}
+
+/**
+ * check_bus_reset
+ */
+static void check_bus_reset(void)
+{
+	struct mouse_report r4 = mk_rep(4), r5 = mk_rep(5), rep;
+	TickType_t t;
+
+	SIM_CHECK(submit_hid_report(USB_JIG_M_IFACE, &r4, 0));
+	SIM_CHECK(submit_hid_report(USB_JIG_M_IFACE, &r5, 0));
+	SIM_CHECK(take_hid_report(USB_JIG_M_IFACE, &rep, 0));
+	SIM_CHECK(is_hid_report_in_flight(USB_JIG_M_IFACE));
+	note_usb_jiggler_bus_reset();
+	SIM_CHECK(!is_hid_report_in_flight(USB_JIG_M_IFACE));
+	t = xTaskGetTickCount();
+	SIM_CHECK(take_hid_report(USB_JIG_M_IFACE, &rep, 10));
+	SIM_CHECK(xTaskGetTickCount() == t);
+	SIM_CHECK(same_rep(&rep, &r5));
+	complete_hid_report(USB_JIG_M_IFACE);
+}
+
+/**
+ * main
+ */
+int main(void)
+{
+	init_usb_jiggler();
+	set_hid_report_done_clbk(USB_JIG_M_IFACE, done_clbk, &done_cnt);
+	check_take();
+	check_blocking();
+	check_total_tmo();
+	check_bus_reset();
+	return (sim_result("test_submit"));
+}
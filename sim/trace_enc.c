@@ -0,0 +1,110 @@
+/*
+ * trace_enc.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_trace.h"
+#include "trace_enc.h"
+
+#define RUN_MAX 64
+
+static int put(uint8_t *out, int size, int *len, uint8_t b);
+
+/**
+ * put
+ */
+static int put(uint8_t *out, int size, int *len, uint8_t b)
+{
+	if (*len >= size) {
+		return (-1);
+	}
+	out[(*len)++] = b;
+	return (0);
+}
+
+/**
+ * encode_mouse_trace
+ */
+int encode_mouse_trace(const struct mouse_report *frms, int n, uint8_t *out, int size)
+{
+	const struct mouse_report *f;
+	struct mouse_report prev = {0};
+	int i, run, len = 0;
+	uint8_t c;
+
+	for (i = 0; i < n; i += run) {
+		f = &frms[i];
+		if (f->x < -127 || f->y < -127 || f->w < -127) {
+			return (-1);
+		}
+		if (f->bm == prev.bm && !f->x && !f->y && !f->w) {
+			for (run = 1; i + run < n && run < RUN_MAX; run++) {
+				if (frms[i + run].bm != prev.bm || frms[i + run].x || frms[i + run].y ||
+				    frms[i + run].w) {
+					break;
+				}
+			}
+			if (put(out, size, &len, MOUSE_TRACE_IDLE | (run - 1))) {
+				return (-1);
+			}
+			prev.x = prev.y = prev.w = 0;
+			continue;
+		}
+		if (f->bm == prev.bm && f->x == prev.x && f->y == prev.y && f->w == prev.w) {
+			for (run = 1; i + run < n && run < RUN_MAX; run++) {
+				if (frms[i + run].bm != prev.bm || frms[i + run].x != prev.x ||
+				    frms[i + run].y != prev.y || frms[i + run].w != prev.w) {
+					break;
+				}
+			}
+			if (put(out, size, &len, MOUSE_TRACE_REPEAT | (run - 1))) {
+				return (-1);
+			}
+			continue;
+		}
+		run = 1;
+		if (f->bm == prev.bm && !f->w && f->x >= -4 && f->x <= 3 && f->y >= -4 && f->y <= 3) {
+			if (put(out, size, &len, (f->x & 7) << 3 | (f->y & 7))) {
+				return (-1);
+			}
+		} else {
+			c = MOUSE_TRACE_FRAME;
+			c |= (f->x) ? MOUSE_TRACE_FRAME_X : 0;
+			c |= (f->y) ? MOUSE_TRACE_FRAME_Y : 0;
+			c |= (f->w) ? MOUSE_TRACE_FRAME_W : 0;
+			c |= (f->bm != prev.bm) ? MOUSE_TRACE_FRAME_BM : 0;
+			if (put(out, size, &len, c) ||
+			    ((c & MOUSE_TRACE_FRAME_X) && put(out, size, &len, f->x)) ||
+			    ((c & MOUSE_TRACE_FRAME_Y) && put(out, size, &len, f->y)) ||
+			    ((c & MOUSE_TRACE_FRAME_W) && put(out, size, &len, f->w)) ||
+			    ((c & MOUSE_TRACE_FRAME_BM) && put(out, size, &len, f->bm))) {
+				return (-1);
+			}
+		}
+		prev = *f;
+	}
+	if (put(out, size, &len, MOUSE_TRACE_END)) {
+		return (-1);
+	}
+	return (len);
+}
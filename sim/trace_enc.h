@@ -0,0 +1,35 @@
+/*
+ * trace_enc.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TRACE_ENC_H
+#define TRACE_ENC_H
+
+/*
+ * Host side encoder of recorded mouse traces (format in mouse_trace.h).
+ */
+
+/**
+ * encode_mouse_trace
+ *
+ * Encodes n frames (one per poll interval, x, y, w deltas -127..127 and
+ * button state) into out of size bytes, including end code. Returns
+ * number of bytes or -1 if a delta is out of range or out is too small.
+ */
+int encode_mouse_trace(const struct mouse_report *frms, int n, uint8_t *out, int size);
+
+#endif
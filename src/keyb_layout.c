@@ -0,0 +1,292 @@
+/*
+ * keyb_layout.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "keyb_typing.h"
+
+#if USB_JIG_KEYB_IFACE == 1
+#define L_SHIFT 0x02
+#define R_ALT 0x40
+
+// US (QWERTY).
+static const struct keyb_keymap_item us_ascii[] = {
+	{{0, 0}, {0, 0x2C}}, // ' '
+	{{0, 0}, {L_SHIFT, 0x1E}}, // '!'
+	{{0, 0}, {L_SHIFT, 0x34}}, // '"'
+	{{0, 0}, {L_SHIFT, 0x20}}, // '#'
+	{{0, 0}, {L_SHIFT, 0x21}}, // '$'
+	{{0, 0}, {L_SHIFT, 0x22}}, // '%'
+	{{0, 0}, {L_SHIFT, 0x24}}, // '&'
+	{{0, 0}, {0, 0x34}}, // '\''
+	{{0, 0}, {L_SHIFT, 0x26}}, // '('
+	{{0, 0}, {L_SHIFT, 0x27}}, // ')'
+	{{0, 0}, {L_SHIFT, 0x25}}, // '*'
+	{{0, 0}, {L_SHIFT, 0x2E}}, // '+'
+	{{0, 0}, {0, 0x36}}, // ','
+	{{0, 0}, {0, 0x2D}}, // '-'
+	{{0, 0}, {0, 0x37}}, // '.'
+	{{0, 0}, {0, 0x38}}, // '/'
+	{{0, 0}, {0, 0x27}}, // '0'
+	{{0, 0}, {0, 0x1E}}, // '1'
+	{{0, 0}, {0, 0x1F}}, // '2'
+	{{0, 0}, {0, 0x20}}, // '3'
+	{{0, 0}, {0, 0x21}}, // '4'
+	{{0, 0}, {0, 0x22}}, // '5'
+	{{0, 0}, {0, 0x23}}, // '6'
+	{{0, 0}, {0, 0x24}}, // '7'
+	{{0, 0}, {0, 0x25}}, // '8'
+	{{0, 0}, {0, 0x26}}, // '9'
+	{{0, 0}, {L_SHIFT, 0x33}}, // ':'
+	{{0, 0}, {0, 0x33}}, // ';'
+	{{0, 0}, {L_SHIFT, 0x36}}, // '<'
+	{{0, 0}, {0, 0x2E}}, // '='
+	{{0, 0}, {L_SHIFT, 0x37}}, // '>'
+	{{0, 0}, {L_SHIFT, 0x38}}, // '?'
+	{{0, 0}, {L_SHIFT, 0x1F}}, // '@'
+	{{0, 0}, {L_SHIFT, 0x04}}, // 'A'
+	{{0, 0}, {L_SHIFT, 0x05}}, // 'B'
+	{{0, 0}, {L_SHIFT, 0x06}}, // 'C'
+	{{0, 0}, {L_SHIFT, 0x07}}, // 'D'
+	{{0, 0}, {L_SHIFT, 0x08}}, // 'E'
+	{{0, 0}, {L_SHIFT, 0x09}}, // 'F'
+	{{0, 0}, {L_SHIFT, 0x0A}}, // 'G'
+	{{0, 0}, {L_SHIFT, 0x0B}}, // 'H'
+	{{0, 0}, {L_SHIFT, 0x0C}}, // 'I'
+	{{0, 0}, {L_SHIFT, 0x0D}}, // 'J'
+	{{0, 0}, {L_SHIFT, 0x0E}}, // 'K'
+	{{0, 0}, {L_SHIFT, 0x0F}}, // 'L'
+	{{0, 0}, {L_SHIFT, 0x10}}, // 'M'
+	{{0, 0}, {L_SHIFT, 0x11}}, // 'N'
+	{{0, 0}, {L_SHIFT, 0x12}}, // 'O'
+	{{0, 0}, {L_SHIFT, 0x13}}, // 'P'
+	{{0, 0}, {L_SHIFT, 0x14}}, // 'Q'
+	{{0, 0}, {L_SHIFT, 0x15}}, // 'R'
+	{{0, 0}, {L_SHIFT, 0x16}}, // 'S'
+	{{0, 0}, {L_SHIFT, 0x17}}, // 'T'
+	{{0, 0}, {L_SHIFT, 0x18}}, // 'U'
+	{{0, 0}, {L_SHIFT, 0x19}}, // 'V'
+	{{0, 0}, {L_SHIFT, 0x1A}}, // 'W'
+	{{0, 0}, {L_SHIFT, 0x1B}}, // 'X'
+	{{0, 0}, {L_SHIFT, 0x1C}}, // 'Y'
+	{{0, 0}, {L_SHIFT, 0x1D}}, // 'Z'
+	{{0, 0}, {0, 0x2F}}, // '['
+	{{0, 0}, {0, 0x31}}, // '\\'
+	{{0, 0}, {0, 0x30}}, // ']'
+	{{0, 0}, {L_SHIFT, 0x23}}, // '^'
+	{{0, 0}, {L_SHIFT, 0x2D}}, // '_'
+	{{0, 0}, {0, 0x35}}, // '`'
+	{{0, 0}, {0, 0x04}}, // 'a'
+	{{0, 0}, {0, 0x05}}, // 'b'
+	{{0, 0}, {0, 0x06}}, // 'c'
+	{{0, 0}, {0, 0x07}}, // 'd'
+	{{0, 0}, {0, 0x08}}, // 'e'
+	{{0, 0}, {0, 0x09}}, // 'f'
+	{{0, 0}, {0, 0x0A}}, // 'g'
+	{{0, 0}, {0, 0x0B}}, // 'h'
+	{{0, 0}, {0, 0x0C}}, // 'i'
+	{{0, 0}, {0, 0x0D}}, // 'j'
+	{{0, 0}, {0, 0x0E}}, // 'k'
+	{{0, 0}, {0, 0x0F}}, // 'l'
+	{{0, 0}, {0, 0x10}}, // 'm'
+	{{0, 0}, {0, 0x11}}, // 'n'
+	{{0, 0}, {0, 0x12}}, // 'o'
+	{{0, 0}, {0, 0x13}}, // 'p'
+	{{0, 0}, {0, 0x14}}, // 'q'
+	{{0, 0}, {0, 0x15}}, // 'r'
+	{{0, 0}, {0, 0x16}}, // 's'
+	{{0, 0}, {0, 0x17}}, // 't'
+	{{0, 0}, {0, 0x18}}, // 'u'
+	{{0, 0}, {0, 0x19}}, // 'v'
+	{{0, 0}, {0, 0x1A}}, // 'w'
+	{{0, 0}, {0, 0x1B}}, // 'x'
+	{{0, 0}, {0, 0x1C}}, // 'y'
+	{{0, 0}, {0, 0x1D}}, // 'z'
+	{{0, 0}, {L_SHIFT, 0x2F}}, // '{'
+	{{0, 0}, {L_SHIFT, 0x31}}, // '|'
+	{{0, 0}, {L_SHIFT, 0x30}}, // '}'
+	{{0, 0}, {L_SHIFT, 0x35}}  // '~'
+};
+
+static const struct keyb_keymap_ext_item us_ext[] = {
+	{0x0009, {{0, 0}, {0, 0x2B}}}, // tab
+	{0x000A, {{0, 0}, {0, 0x28}}}  // enter
+};
+
+const struct keyb_layout keyb_layout_us = {
+	.nm = "us",
+	.ascii = us_ascii,
+	.ext = us_ext,
+	.ext_nmb = sizeof(us_ext) / sizeof(us_ext[0])
+};
+
+// Slovak (QWERTZ), R_ALT is AltGr, dead keys: acute, caron, circumflex, grave, diaeresis.
+static const struct keyb_keymap_item sk_ascii[] = {
+	{{0, 0}, {0, 0x2C}}, // ' '
+	{{0, 0}, {L_SHIFT, 0x34}}, // '!'
+	{{0, 0}, {L_SHIFT, 0x33}}, // '"'
+	{{0, 0}, {R_ALT, 0x1B}}, // '#'
+	{{0, 0}, {R_ALT, 0x33}}, // '$'
+	{{0, 0}, {L_SHIFT, 0x2D}}, // '%'
+	{{0, 0}, {R_ALT, 0x06}}, // '&'
+	{{0, 0}, {0, 0}}, // '\''
+	{{0, 0}, {L_SHIFT, 0x30}}, // '('
+	{{0, 0}, {L_SHIFT, 0x31}}, // ')'
+	{{0, 0}, {R_ALT, 0x38}}, // '*'
+	{{0, 0}, {0, 0x1E}}, // '+'
+	{{0, 0}, {0, 0x36}}, // ','
+	{{0, 0}, {0, 0x38}}, // '-'
+	{{0, 0}, {0, 0x37}}, // '.'
+	{{0, 0}, {L_SHIFT, 0x2F}}, // '/'
+	{{0, 0}, {L_SHIFT, 0x27}}, // '0'
+	{{0, 0}, {L_SHIFT, 0x1E}}, // '1'
+	{{0, 0}, {L_SHIFT, 0x1F}}, // '2'
+	{{0, 0}, {L_SHIFT, 0x20}}, // '3'
+	{{0, 0}, {L_SHIFT, 0x21}}, // '4'
+	{{0, 0}, {L_SHIFT, 0x22}}, // '5'
+	{{0, 0}, {L_SHIFT, 0x23}}, // '6'
+	{{0, 0}, {L_SHIFT, 0x24}}, // '7'
+	{{0, 0}, {L_SHIFT, 0x25}}, // '8'
+	{{0, 0}, {L_SHIFT, 0x26}}, // '9'
+	{{0, 0}, {L_SHIFT, 0x37}}, // ':'
+	{{0, 0}, {0, 0x35}}, // ';'
+	{{0, 0}, {R_ALT, 0x36}}, // '<'
+	{{0, 0}, {0, 0x2D}}, // '='
+	{{0, 0}, {R_ALT, 0x37}}, // '>'
+	{{0, 0}, {L_SHIFT, 0x36}}, // '?'
+	{{0, 0}, {R_ALT, 0x19}}, // '@'
+	{{0, 0}, {L_SHIFT, 0x04}}, // 'A'
+	{{0, 0}, {L_SHIFT, 0x05}}, // 'B'
+	{{0, 0}, {L_SHIFT, 0x06}}, // 'C'
+	{{0, 0}, {L_SHIFT, 0x07}}, // 'D'
+	{{0, 0}, {L_SHIFT, 0x08}}, // 'E'
+	{{0, 0}, {L_SHIFT, 0x09}}, // 'F'
+	{{0, 0}, {L_SHIFT, 0x0A}}, // 'G'
+	{{0, 0}, {L_SHIFT, 0x0B}}, // 'H'
+	{{0, 0}, {L_SHIFT, 0x0C}}, // 'I'
+	{{0, 0}, {L_SHIFT, 0x0D}}, // 'J'
+	{{0, 0}, {L_SHIFT, 0x0E}}, // 'K'
+	{{0, 0}, {L_SHIFT, 0x0F}}, // 'L'
+	{{0, 0}, {L_SHIFT, 0x10}}, // 'M'
+	{{0, 0}, {L_SHIFT, 0x11}}, // 'N'
+	{{0, 0}, {L_SHIFT, 0x12}}, // 'O'
+	{{0, 0}, {L_SHIFT, 0x13}}, // 'P'
+	{{0, 0}, {L_SHIFT, 0x14}}, // 'Q'
+	{{0, 0}, {L_SHIFT, 0x15}}, // 'R'
+	{{0, 0}, {L_SHIFT, 0x16}}, // 'S'
+	{{0, 0}, {L_SHIFT, 0x17}}, // 'T'
+	{{0, 0}, {L_SHIFT, 0x18}}, // 'U'
+	{{0, 0}, {L_SHIFT, 0x19}}, // 'V'
+	{{0, 0}, {L_SHIFT, 0x1A}}, // 'W'
+	{{0, 0}, {L_SHIFT, 0x1B}}, // 'X'
+	{{0, 0}, {L_SHIFT, 0x1D}}, // 'Y'
+	{{0, 0}, {L_SHIFT, 0x1C}}, // 'Z'
+	{{0, 0}, {R_ALT, 0x09}}, // '['
+	{{0, 0}, {R_ALT, 0x14}}, // '\\'
+	{{0, 0}, {R_ALT, 0x0A}}, // ']'
+	{{R_ALT, 0x20}, {0, 0x2C}}, // '^'
+	{{0, 0}, {L_SHIFT, 0x38}}, // '_'
+	{{R_ALT, 0x24}, {0, 0x2C}}, // '`'
+	{{0, 0}, {0, 0x04}}, // 'a'
+	{{0, 0}, {0, 0x05}}, // 'b'
+	{{0, 0}, {0, 0x06}}, // 'c'
+	{{0, 0}, {0, 0x07}}, // 'd'
+	{{0, 0}, {0, 0x08}}, // 'e'
+	{{0, 0}, {0, 0x09}}, // 'f'
+	{{0, 0}, {0, 0x0A}}, // 'g'
+	{{0, 0}, {0, 0x0B}}, // 'h'
+	{{0, 0}, {0, 0x0C}}, // 'i'
+	{{0, 0}, {0, 0x0D}}, // 'j'
+	{{0, 0}, {0, 0x0E}}, // 'k'
+	{{0, 0}, {0, 0x0F}}, // 'l'
+	{{0, 0}, {0, 0x10}}, // 'm'
+	{{0, 0}, {0, 0x11}}, // 'n'
+	{{0, 0}, {0, 0x12}}, // 'o'
+	{{0, 0}, {0, 0x13}}, // 'p'
+	{{0, 0}, {0, 0x14}}, // 'q'
+	{{0, 0}, {0, 0x15}}, // 'r'
+	{{0, 0}, {0, 0x16}}, // 's'
+	{{0, 0}, {0, 0x17}}, // 't'
+	{{0, 0}, {0, 0x18}}, // 'u'
+	{{0, 0}, {0, 0x19}}, // 'v'
+	{{0, 0}, {0, 0x1A}}, // 'w'
+	{{0, 0}, {0, 0x1B}}, // 'x'
+	{{0, 0}, {0, 0x1D}}, // 'y'
+	{{0, 0}, {0, 0x1C}}, // 'z'
+	{{0, 0}, {R_ALT, 0x05}}, // '{'
+	{{0, 0}, {R_ALT, 0x1A}}, // '|'
+	{{0, 0}, {R_ALT, 0x11}}, // '}'
+	{{0, 0}, {R_ALT, 0x1E}}  // '~'
+};
+
+static const struct keyb_keymap_ext_item sk_ext[] = {
+	{0x0009, {{0, 0}, {0, 0x2B}}}, // tab
+	{0x000A, {{0, 0}, {0, 0x28}}}, // enter
+	{0x00A7, {{0, 0}, {0, 0x34}}}, // section sign
+	{0x00B0, {{0, 0}, {L_SHIFT, 0x35}}}, // degree sign
+	{0x00C1, {{0, 0x2E}, {L_SHIFT, 0x04}}}, // A acute
+	{0x00C4, {{R_ALT, 0x2D}, {L_SHIFT, 0x04}}}, // A diaeresis
+	{0x00C9, {{0, 0x2E}, {L_SHIFT, 0x08}}}, // E acute
+	{0x00CD, {{0, 0x2E}, {L_SHIFT, 0x0C}}}, // I acute
+	{0x00D3, {{0, 0x2E}, {L_SHIFT, 0x12}}}, // O acute
+	{0x00D4, {{R_ALT, 0x20}, {L_SHIFT, 0x12}}}, // O circumflex
+	{0x00DA, {{0, 0x2E}, {L_SHIFT, 0x18}}}, // U acute
+	{0x00DD, {{0, 0x2E}, {L_SHIFT, 0x1D}}}, // Y acute
+	{0x00E1, {{0, 0}, {0, 0x25}}}, // a acute
+	{0x00E4, {{0, 0}, {0, 0x30}}}, // a diaeresis
+	{0x00E9, {{0, 0}, {0, 0x27}}}, // e acute
+	{0x00ED, {{0, 0}, {0, 0x26}}}, // i acute
+	{0x00F3, {{0, 0x2E}, {0, 0x12}}}, // o acute
+	{0x00F4, {{0, 0}, {0, 0x33}}}, // o circumflex
+	{0x00FA, {{0, 0}, {0, 0x2F}}}, // u acute
+	{0x00FD, {{0, 0}, {0, 0x24}}}, // y acute
+	{0x010C, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x06}}}, // C caron
+	{0x010D, {{0, 0}, {0, 0x21}}}, // c caron
+	{0x010E, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x07}}}, // D caron
+	{0x010F, {{L_SHIFT, 0x2E}, {0, 0x07}}}, // d caron
+	{0x0139, {{0, 0x2E}, {L_SHIFT, 0x0F}}}, // L acute
+	{0x013A, {{0, 0x2E}, {0, 0x0F}}}, // l acute
+	{0x013D, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x0F}}}, // L caron
+	{0x013E, {{0, 0}, {0, 0x1F}}}, // l caron
+	{0x0147, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x11}}}, // N caron
+	{0x0148, {{0, 0}, {0, 0x31}}}, // n caron
+	{0x0154, {{0, 0x2E}, {L_SHIFT, 0x15}}}, // R acute
+	{0x0155, {{0, 0x2E}, {0, 0x15}}}, // r acute
+	{0x0160, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x16}}}, // S caron
+	{0x0161, {{0, 0}, {0, 0x20}}}, // s caron
+	{0x0164, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x17}}}, // T caron
+	{0x0165, {{0, 0}, {0, 0x22}}}, // t caron
+	{0x017D, {{L_SHIFT, 0x2E}, {L_SHIFT, 0x1C}}}, // Z caron
+	{0x017E, {{0, 0}, {0, 0x23}}}, // z caron
+	{0x20AC, {{0, 0}, {R_ALT, 0x08}}}  // euro sign
+};
+
+const struct keyb_layout keyb_layout_sk = {
+	.nm = "sk",
+	.ascii = sk_ascii,
+	.ext = sk_ext,
+	.ext_nmb = sizeof(sk_ext) / sizeof(sk_ext[0])
+};
+#endif
@@ -0,0 +1,187 @@
+/*
+ * keyb_typing.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "keyb_typing.h"
+
+#if USB_JIG_KEYB_IFACE == 1
+static const struct keyb_stroke *peek_stroke(struct keyb_typing *kt);
+static const struct keyb_keymap_item *find_keymap_item(const struct keyb_layout *lay, uint16_t cp);
+static uint16_t next_code_point(const char **txt);
+static boolean_t has_key(const struct keyb_report *rep, uint8_t key);
+
+/**
+ * start_keyb_typing
+ */
+void start_keyb_typing(struct keyb_typing *kt, const char *txt, const struct keyb_layout *lay)
+{
+	memset(kt, 0, sizeof(struct keyb_typing));
+	kt->lay = lay;
+	kt->txt = txt;
+}
+
+/**
+ * get_keyb_typing_report
+ */
+boolean_t get_keyb_typing_report(struct keyb_typing *kt, struct keyb_report *rep)
+{
+	const struct keyb_stroke *s;
+	int n;
+
+	memset(rep, 0, sizeof(struct keyb_report));
+	if (!(s = peek_stroke(kt)) || has_key(&kt->prev, s->key)) {
+		// Text end or repeated key - release all.
+		if (!s && !memcmp(rep, &kt->prev, sizeof(struct keyb_report))) {
+			return (FALSE);
+		}
+		kt->prev = *rep;
+		return (TRUE);
+	}
+	rep->mod = s->mod;
+	n = 0;
+	do {
+#if USB_JIG_KEYB_NKRO == 1
+		// Host scans bitmap in usage order, keep typing order.
+		if (n && s->key <= n) {
+			break;
+		}
+#else
+		if (n == KEYB_REPORT_KEY_ARY_SIZE) {
+			break;
+		}
+#endif
+		add_keyb_report_key(rep, s->key);
+#if USB_JIG_KEYB_NKRO == 1
+		n = s->key;
+#else
+		n++;
+#endif
+		if (kt->stroke_idx++ == 0 && kt->stroke_nmb == 2) {
+			// Dead key goes alone, compose state needs it first.
+			break;
+		}
+	} while ((s = peek_stroke(kt)) && s->mod == rep->mod && !has_key(rep, s->key) &&
+		 !has_key(&kt->prev, s->key));
+	kt->prev = *rep;
+	return (TRUE);
+}
+
+/**
+ * peek_stroke
+ */
+static const struct keyb_stroke *peek_stroke(struct keyb_typing *kt)
+{
+	const struct keyb_keymap_item *ki;
+
+	while (kt->stroke_idx == kt->stroke_nmb) {
+		if (!*kt->txt) {
+			return (NULL);
+		}
+		if (!(ki = find_keymap_item(kt->lay, next_code_point(&kt->txt)))) {
+			continue;
+		}
+		kt->stroke_idx = kt->stroke_nmb = 0;
+		if (ki->dead.key) {
+			kt->strokes[kt->stroke_nmb++] = ki->dead;
+		}
+		kt->strokes[kt->stroke_nmb++] = ki->stroke;
+	}
+	return (&kt->strokes[kt->stroke_idx]);
+}
+
+/**
+ * find_keymap_item
+ */
+static const struct keyb_keymap_item *find_keymap_item(const struct keyb_layout *lay, uint16_t cp)
+{
+	const struct keyb_keymap_item *ki = NULL;
+	int lo, hi, i;
+
+	if (cp >= 0x20 && cp <= 0x7E) {
+		ki = &lay->ascii[cp - 0x20];
+	} else {
+		lo = 0;
+		hi = lay->ext_nmb - 1;
+		while (lo <= hi) {
+			i = (lo + hi) / 2;
+			if (lay->ext[i].cp == cp) {
+				ki = &lay->ext[i].ki;
+				break;
+			} else if (lay->ext[i].cp < cp) {
+				lo = i + 1;
+			} else {
+				hi = i - 1;
+			}
+		}
+	}
+	if (ki && ki->stroke.key) {
+		return (ki);
+	}
+	return (NULL);
+}
+
+/**
+ * next_code_point
+ */
+static uint16_t next_code_point(const char **txt)
+{
+	const uint8_t *s = (const uint8_t *) *txt;
+
+	if (s[0] < 0x80) {
+		*txt += 1;
+		return (s[0]);
+	} else if ((s[0] & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80) {
+		*txt += 2;
+		return ((s[0] & 0x1F) << 6 | (s[1] & 0x3F));
+	} else if ((s[0] & 0xF0) == 0xE0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+		*txt += 3;
+		return ((s[0] & 0x0F) << 12 | (s[1] & 0x3F) << 6 | (s[2] & 0x3F));
+	}
+	// Invalid or 4 byte sequence, skip byte.
+	*txt += 1;
+	return (0xFFFD);
+}
+
+/**
+ * has_key
+ */
+static boolean_t has_key(const struct keyb_report *rep, uint8_t key)
+{
+#if USB_JIG_KEYB_NKRO == 1
+	return (key <= KEYB_REPORT_USAGE_MAX && (rep->bitmap[key >> 3] & (1 << (key & 7))));
+#else
+	int i;
+
+	for (i = 0; i < KEYB_REPORT_KEY_ARY_SIZE; i++) {
+		if (rep->keys[i] == key) {
+			return (TRUE);
+		}
+	}
+	return (FALSE);
+#endif
+}
+#endif
@@ -0,0 +1,84 @@
+/*
+ * keyb_typing.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef KEYB_TYPING_H
+#define KEYB_TYPING_H
+
+#if USB_JIG_KEYB_IFACE == 1
+struct keyb_stroke {
+	uint8_t mod;
+	uint8_t key;
+};
+
+/*
+ * Strokes typing one character: dead key stroke (key 0 - none) and key
+ * stroke (key 0 - character not available in layout).
+ */
+struct keyb_keymap_item {
+	struct keyb_stroke dead;
+	struct keyb_stroke stroke;
+};
+
+struct keyb_keymap_ext_item {
+	uint16_t cp;
+	struct keyb_keymap_item ki;
+};
+
+/*
+ * Keyboard layout: characters 0x20 to 0x7E (ascii) and other code points
+ * sorted in ascending order (ext).
+ */
+struct keyb_layout {
+	const char *nm;
+	const struct keyb_keymap_item *ascii;
+	const struct keyb_keymap_ext_item *ext;
+	int ext_nmb;
+};
+
+extern const struct keyb_layout keyb_layout_us;
+extern const struct keyb_layout keyb_layout_sk;
+
+struct keyb_typing {
+	const struct keyb_layout *lay;
+	const char *txt;
+	struct keyb_stroke strokes[2];
+	int stroke_idx;
+	int stroke_nmb;
+	struct keyb_report prev;
+};
+
+/**
+ * start_keyb_typing
+ *
+ * Starts typing of UTF-8 string txt (must stay valid until typed) with
+ * layout lay. Characters missing in layout are skipped.
+ */
+void start_keyb_typing(struct keyb_typing *kt, const char *txt, const struct keyb_layout *lay);
+
+/**
+ * get_keyb_typing_report
+ *
+ * Fills report for the next host poll. Distinct keys with equal modifiers
+ * are pressed together (up to rollover limit), release report is inserted
+ * only before repeated key. Returns FALSE when text is typed and all keys
+ * are released.
+ */
+boolean_t get_keyb_typing_report(struct keyb_typing *kt, struct keyb_report *rep);
+#endif
+
+#endif
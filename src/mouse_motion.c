@@ -0,0 +1,130 @@
+/*
+ * mouse_motion.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_motion.h"
+
+#define REP_DELTA_MAX 127
+
+/*
+ * Motion accumulated under one button state. New segment is started on
+ * every button change, so segments are reported in the order of edges.
+ */
+static struct motion_seg {
+	int32_t dx;
+	int32_t dy;
+	int32_t dw;
+	uint8_t bm;
+} segs[MOUSE_MOTION_SEG_NMB];
+
+static int seg_head, seg_tail, seg_cnt = 1;
+static uint8_t rep_bm;
+
+static int8_t take_delta(int32_t *acc);
+
+/**
+ * add_mouse_motion
+ */
+void add_mouse_motion(int dx, int dy, int dw)
+{
+	struct motion_seg *s;
+
+	taskENTER_CRITICAL();
+	s = &segs[seg_tail];
+	s->dx += dx;
+	s->dy += dy;
+	s->dw += dw;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * set_mouse_buttons
+ */
+boolean_t set_mouse_buttons(uint8_t bm)
+{
+	struct motion_seg *s;
+	boolean_t ret = TRUE;
+
+	taskENTER_CRITICAL();
+	if (segs[seg_tail].bm != bm) {
+		if (seg_cnt < MOUSE_MOTION_SEG_NMB) {
+			if (++seg_tail == MOUSE_MOTION_SEG_NMB) {
+				seg_tail = 0;
+			}
+			seg_cnt++;
+			s = &segs[seg_tail];
+			s->dx = s->dy = s->dw = 0;
+			s->bm = bm;
+		} else {
+			ret = FALSE;
+		}
+	}
+	taskEXIT_CRITICAL();
+	return (ret);
+}
+
+/**
+ * get_mouse_motion_report
+ */
+boolean_t get_mouse_motion_report(struct mouse_report *rep)
+{
+	struct motion_seg *s;
+	boolean_t chng;
+
+	taskENTER_CRITICAL();
+	s = &segs[seg_head];
+	rep->bm = s->bm;
+	rep->x = take_delta(&s->dx);
+	rep->y = take_delta(&s->dy);
+	rep->w = take_delta(&s->dw);
+	if (seg_cnt > 1 && !s->dx && !s->dy && !s->dw) {
+		if (++seg_head == MOUSE_MOTION_SEG_NMB) {
+			seg_head = 0;
+		}
+		seg_cnt--;
+	}
+	chng = rep->x || rep->y || rep->w || rep->bm != rep_bm;
+	rep_bm = rep->bm;
+	taskEXIT_CRITICAL();
+	return (chng);
+}
+
+/**
+ * take_delta
+ */
+static int8_t take_delta(int32_t *acc)
+{
+	int32_t d;
+
+	d = *acc;
+	if (d > REP_DELTA_MAX) {
+		d = REP_DELTA_MAX;
+	} else if (d < -REP_DELTA_MAX) {
+		d = -REP_DELTA_MAX;
+	}
+	*acc -= d;
+	return (d);
+}
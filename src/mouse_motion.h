@@ -0,0 +1,55 @@
+/*
+ * mouse_motion.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MOUSE_MOTION_H
+#define MOUSE_MOTION_H
+
+/*
+ * MOUSE_MOTION_SEG_NMB
+ *   Number of button states (edges) which may wait for the host poll.
+ */
+#ifndef MOUSE_MOTION_SEG_NMB
+#define MOUSE_MOTION_SEG_NMB 8
+#endif
+
+/**
+ * add_mouse_motion
+ *
+ * Adds relative motion to the accumulator. Motion is reported with the last
+ * button state set by set_mouse_buttons().
+ */
+void add_mouse_motion(int dx, int dy, int dw);
+
+/**
+ * set_mouse_buttons
+ *
+ * Queues new button state. Returns FALSE if MOUSE_MOTION_SEG_NMB button
+ * states already wait for report.
+ */
+boolean_t set_mouse_buttons(uint8_t bm);
+
+/**
+ * get_mouse_motion_report
+ *
+ * Fills report for the next host poll. Moves larger than report range are
+ * split across consecutive reports, button edges are reported in order.
+ * Returns TRUE if report carries motion or button change.
+ */
+boolean_t get_mouse_motion_report(struct mouse_report *rep);
+
+#endif
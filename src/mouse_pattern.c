@@ -0,0 +1,256 @@
+/*
+ * mouse_pattern.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_pattern.h"
+
+#define REP_DELTA_MAX 127
+#define Q15_ONE 32768
+
+// Phase step of 1 step period (65536) does not fit uint16_t.
+#define LSJ_PER_MIN 2
+
+// sin() of first quadrant in 64 steps, Q15.
+static const int16_t sin_lut[] = {
+	    0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+	 6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+	12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+	18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+	23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+	27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+	30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+	32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+	32767
+};
+
+static void step_lissajous(struct mouse_pattern *mp);
+static void step_random_walk(struct mouse_pattern *mp);
+static void step_bezier(struct mouse_pattern *mp);
+static int32_t sin_q15(uint16_t ph);
+static int8_t take_delta(int32_t pos, int32_t *out);
+
+/**
+ * init_mouse_pattern_circle
+ */
+void init_mouse_pattern_circle(struct mouse_pattern *mp, int r, int period, int steps)
+{
+	init_mouse_pattern_lissajous(mp, r, r, period, period, 0x4000, steps);
+}
+
+/**
+ * init_mouse_pattern_lissajous
+ */
+void init_mouse_pattern_lissajous(struct mouse_pattern *mp, int amp_x, int amp_y,
+				  int per_x, int per_y, uint16_t phase, int steps)
+{
+	mp->type = MOUSE_PATTERN_LISSAJOUS;
+	mp->steps = (steps) ? steps : -1;
+	mp->lsj.amp_x = amp_x;
+	mp->lsj.amp_y = amp_y;
+	mp->lsj.ph_x = phase;
+	mp->lsj.ph_y = 0;
+	mp->lsj.step_x = (per_x > 0) ? 65536 / ((per_x < LSJ_PER_MIN) ? LSJ_PER_MIN : per_x) : 0;
+	mp->lsj.step_y = (per_y > 0) ? 65536 / ((per_y < LSJ_PER_MIN) ? LSJ_PER_MIN : per_y) : 0;
+	mp->pos_x = (amp_x * sin_q15(mp->lsj.ph_x)) >> 7;
+	mp->pos_y = (amp_y * sin_q15(mp->lsj.ph_y)) >> 7;
+	mp->out_x = mp->pos_x >> 8;
+	mp->out_y = mp->pos_y >> 8;
+}
+
+/**
+ * init_mouse_pattern_random_walk
+ */
+void init_mouse_pattern_random_walk(struct mouse_pattern *mp, int vel_max, uint32_t seed, int steps)
+{
+	mp->type = MOUSE_PATTERN_RANDOM_WALK;
+	mp->steps = (steps) ? steps : -1;
+	mp->pos_x = mp->pos_y = 0;
+	mp->out_x = mp->out_y = 0;
+	mp->rw.vel_x = mp->rw.vel_y = 0;
+	if (vel_max > REP_DELTA_MAX) {
+		vel_max = REP_DELTA_MAX;
+	}
+	mp->rw.vel_max = vel_max << 8;
+	mp->rw.rnd = (seed) ? seed : 1;
+}
+
+/**
+ * init_mouse_pattern_bezier
+ */
+void init_mouse_pattern_bezier(struct mouse_pattern *mp, const int16_t pts[3][2], int steps)
+{
+	int i;
+
+	mp->type = MOUSE_PATTERN_BEZIER;
+	if (steps < 1) {
+		steps = 1;
+	}
+	mp->steps = steps;
+	mp->pos_x = mp->pos_y = 0;
+	mp->out_x = mp->out_y = 0;
+	for (i = 0; i < 3; i++) {
+		mp->bez.pts[i][0] = pts[i][0];
+		mp->bez.pts[i][1] = pts[i][1];
+	}
+	mp->bez.t = 0;
+	mp->bez.dt = (Q15_ONE / steps) ? Q15_ONE / steps : 1;
+}
+
+/**
+ * get_mouse_pattern_report
+ */
+boolean_t get_mouse_pattern_report(struct mouse_pattern *mp, struct mouse_report *rep)
+{
+	if (mp->steps == 0) {
+		rep->x = rep->y = 0;
+		return (FALSE);
+	}
+	switch (mp->type) {
+	case MOUSE_PATTERN_LISSAJOUS :
+		step_lissajous(mp);
+		break;
+	case MOUSE_PATTERN_RANDOM_WALK :
+		step_random_walk(mp);
+		break;
+	case MOUSE_PATTERN_BEZIER :
+		step_bezier(mp);
+		break;
+	}
+	if (mp->steps > 0) {
+		mp->steps--;
+	}
+	rep->x = take_delta(mp->pos_x, &mp->out_x);
+	rep->y = take_delta(mp->pos_y, &mp->out_y);
+	return (TRUE);
+}
+
+/**
+ * step_lissajous
+ */
+static void step_lissajous(struct mouse_pattern *mp)
+{
+	mp->lsj.ph_x += mp->lsj.step_x;
+	mp->lsj.ph_y += mp->lsj.step_y;
+	// amp * Q15 -> Q8.
+	mp->pos_x = (mp->lsj.amp_x * sin_q15(mp->lsj.ph_x)) >> 7;
+	mp->pos_y = (mp->lsj.amp_y * sin_q15(mp->lsj.ph_y)) >> 7;
+}
+
+/**
+ * step_random_walk
+ */
+static void step_random_walk(struct mouse_pattern *mp)
+{
+	uint32_t r;
+	int32_t *v[2] = {&mp->rw.vel_x, &mp->rw.vel_y};
+	int32_t *p[2] = {&mp->pos_x, &mp->pos_y};
+	int i;
+
+	// xorshift32
+	r = mp->rw.rnd;
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	mp->rw.rnd = r;
+	for (i = 0; i < 2; i++, r >>= 16) {
+		// Kick up to vel_max / 4, friction 1/16, pull back 1/256 of offset.
+		*v[i] += ((int16_t) r * mp->rw.vel_max) >> 17;
+		*v[i] -= *v[i] >> 4;
+		*v[i] -= *p[i] >> 8;
+		if (*v[i] > mp->rw.vel_max) {
+			*v[i] = mp->rw.vel_max;
+		} else if (*v[i] < -mp->rw.vel_max) {
+			*v[i] = -mp->rw.vel_max;
+		}
+		*p[i] += *v[i];
+	}
+}
+
+/**
+ * step_bezier
+ */
+static void step_bezier(struct mouse_pattern *mp)
+{
+	uint32_t t, u, t2, u2, b1, b2, b3;
+
+	if (mp->steps == 1 || Q15_ONE - mp->bez.t <= mp->bez.dt) {
+		mp->bez.t = Q15_ONE;
+	} else {
+		mp->bez.t += mp->bez.dt;
+	}
+	t = mp->bez.t;
+	u = Q15_ONE - t;
+	t2 = (t * t) >> 15;
+	u2 = (u * u) >> 15;
+	// Bernstein weights of P1..P3 (P0 is start point), sum <= Q15_ONE.
+	b1 = (3 * u2 * t) >> 15;
+	b2 = (3 * u * t2) >> 15;
+	b3 = (t2 * t) >> 15;
+	// Q15 * pixels -> Q8.
+	mp->pos_x = ((int32_t) b1 * mp->bez.pts[0][0] + (int32_t) b2 * mp->bez.pts[1][0] +
+		     (int32_t) b3 * mp->bez.pts[2][0]) >> 7;
+	mp->pos_y = ((int32_t) b1 * mp->bez.pts[0][1] + (int32_t) b2 * mp->bez.pts[1][1] +
+		     (int32_t) b3 * mp->bez.pts[2][1]) >> 7;
+}
+
+/**
+ * sin_q15
+ */
+static int32_t sin_q15(uint16_t ph)
+{
+	uint16_t idx;
+	int32_t v;
+	int i;
+
+	idx = ph & 0x3FFF;
+	if (ph & 0x4000) {
+		idx = 0x4000 - idx;
+	}
+	i = idx >> 8;
+	if (i == 64) {
+		v = sin_lut[64];
+	} else {
+		v = sin_lut[i] + (((sin_lut[i + 1] - sin_lut[i]) * (idx & 0xFF)) >> 8);
+	}
+	return ((ph & 0x8000) ? -v : v);
+}
+
+/**
+ * take_delta
+ */
+static int8_t take_delta(int32_t pos, int32_t *out)
+{
+	int32_t d;
+
+	d = (pos >> 8) - *out;
+	if (d > REP_DELTA_MAX) {
+		d = REP_DELTA_MAX;
+	} else if (d < -REP_DELTA_MAX) {
+		d = -REP_DELTA_MAX;
+	}
+	*out += d;
+	return (d);
+}
@@ -0,0 +1,119 @@
+/*
+ * mouse_pattern.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MOUSE_PATTERN_H
+#define MOUSE_PATTERN_H
+
+/*
+ * Pattern length and periods are given in steps, one step is one report
+ * (one USB_JIG_IN_M_ENDP_POLLED_MS poll interval).
+ */
+#define MOUSE_PATTERN_MS_TO_STEPS(ms) ((ms) / USB_JIG_IN_M_ENDP_POLLED_MS)
+
+/*
+ * Cycle budget of one get_mouse_pattern_report() step of any pattern
+ * (Cortex-M3 class core, single cycle multiply). Host benchmark
+ * (sim/bench_pattern.c) checks cycles per step against it.
+ */
+#define MOUSE_PATTERN_STEP_CYCLES 150
+
+enum mouse_pattern_type {
+	MOUSE_PATTERN_LISSAJOUS,
+	MOUSE_PATTERN_RANDOM_WALK,
+	MOUSE_PATTERN_BEZIER
+};
+
+/*
+ * Positions are relative to the pattern start in 1/256 pixel units (Q8),
+ * phases are uint16_t with 65536 as full period.
+ */
+struct mouse_pattern {
+	enum mouse_pattern_type type;
+	int steps;
+	int32_t pos_x;
+	int32_t pos_y;
+	int32_t out_x;
+	int32_t out_y;
+	union {
+		struct {
+			int16_t amp_x;
+			int16_t amp_y;
+			uint16_t ph_x;
+			uint16_t ph_y;
+			uint16_t step_x;
+			uint16_t step_y;
+		} lsj;
+		struct {
+			int32_t vel_x;
+			int32_t vel_y;
+			int32_t vel_max;
+			uint32_t rnd;
+		} rw;
+		struct {
+			int16_t pts[3][2];
+			uint16_t t;
+			uint16_t dt;
+		} bez;
+	};
+};
+
+/**
+ * init_mouse_pattern_circle
+ *
+ * Circle with radius r pixels, one turn takes period steps. Pattern runs
+ * steps steps (0 - endless).
+ */
+void init_mouse_pattern_circle(struct mouse_pattern *mp, int r, int period, int steps);
+
+/**
+ * init_mouse_pattern_lissajous
+ *
+ * Lissajous curve x = amp_x * sin(2pi * t / per_x + phase),
+ * y = amp_y * sin(2pi * t / per_y), amplitudes in pixels, periods in steps
+ * (0 - static axis, 1 is taken as 2), phase in 1/65536 of turn.
+ */
+void init_mouse_pattern_lissajous(struct mouse_pattern *mp, int amp_x, int amp_y,
+				  int per_x, int per_y, uint16_t phase, int steps);
+
+/**
+ * init_mouse_pattern_random_walk
+ *
+ * Random walk with speed limited to vel_max pixels per step, softly pulled
+ * back to the start point.
+ */
+void init_mouse_pattern_random_walk(struct mouse_pattern *mp, int vel_max, uint32_t seed, int steps);
+
+/**
+ * init_mouse_pattern_bezier
+ *
+ * Cubic Bezier path from the current position through control points
+ * pts[0], pts[1] to end point pts[2] (pixels, relative to start) in steps
+ * steps.
+ */
+void init_mouse_pattern_bezier(struct mouse_pattern *mp, const int16_t pts[3][2], int steps);
+
+/**
+ * get_mouse_pattern_report
+ *
+ * Computes next step and fills x, y of report (bm, w are left intact).
+ * Returns FALSE after the last step. Step costs a few multiplications and
+ * table lookups, no divisions and no loops.
+ */
+boolean_t get_mouse_pattern_report(struct mouse_pattern *mp, struct mouse_report *rep);
+
+#endif
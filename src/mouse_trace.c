@@ -0,0 +1,110 @@
+/*
+ * mouse_trace.c
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "usb_std_def.h"
+#include "udp.h"
+#include "usb_ctl_req.h"
+#include "usb_jiggler.h"
+#include "mouse_trace.h"
+
+static boolean_t decode_code(struct mouse_trace *mt);
+
+/**
+ * start_mouse_trace
+ */
+void start_mouse_trace(struct mouse_trace *mt, const uint8_t *data, boolean_t loop)
+{
+	mt->data = mt->p = data;
+	mt->loop = loop;
+	mt->run = 0;
+	mt->rep.bm = 0;
+	mt->rep.x = mt->rep.y = mt->rep.w = 0;
+}
+
+/**
+ * get_mouse_trace_report
+ */
+boolean_t get_mouse_trace_report(struct mouse_trace *mt, struct mouse_report *rep)
+{
+	boolean_t ok = TRUE;
+
+	if (mt->run) {
+		mt->run--;
+	} else if (!decode_code(mt)) {
+		// Empty trace can't loop.
+		if (mt->loop && mt->p != mt->data) {
+			mt->p = mt->data;
+			ok = decode_code(mt);
+		} else {
+			ok = FALSE;
+		}
+	}
+	if (!ok) {
+		rep->bm = mt->rep.bm;
+		rep->x = rep->y = rep->w = 0;
+		return (FALSE);
+	}
+	*rep = mt->rep;
+	return (TRUE);
+}
+
+/**
+ * decode_code
+ */
+static boolean_t decode_code(struct mouse_trace *mt)
+{
+	uint8_t c;
+
+	c = *mt->p;
+	switch (c & 0xC0) {
+	case 0x00 :
+		if (c == MOUSE_TRACE_END) {
+			return (FALSE);
+		}
+		// Sign extend 3 bit fields.
+		mt->rep.x = (int8_t) (c << 2) >> 5;
+		mt->rep.y = (int8_t) (c << 5) >> 5;
+		mt->rep.w = 0;
+		break;
+	case MOUSE_TRACE_REPEAT :
+		mt->run = c & 0x3F;
+		break;
+	case MOUSE_TRACE_IDLE :
+		mt->run = c & 0x3F;
+		mt->rep.x = mt->rep.y = mt->rep.w = 0;
+		break;
+	default :
+		if (c & 0x30) {
+			return (FALSE);
+		}
+		mt->rep.x = (c & MOUSE_TRACE_FRAME_X) ? (int8_t) *++mt->p : 0;
+		mt->rep.y = (c & MOUSE_TRACE_FRAME_Y) ? (int8_t) *++mt->p : 0;
+		mt->rep.w = (c & MOUSE_TRACE_FRAME_W) ? (int8_t) *++mt->p : 0;
+		if (c & MOUSE_TRACE_FRAME_BM) {
+			mt->rep.bm = *++mt->p;
+		}
+		break;
+	}
+	mt->p++;
+	return (TRUE);
+}
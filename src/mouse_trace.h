@@ -0,0 +1,66 @@
+/*
+ * mouse_trace.h
+ *
+ * Copyright (c) 2026 Jan Rusnak <jan@rusnak.sk>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MOUSE_TRACE_H
+#define MOUSE_TRACE_H
+
+/*
+ * Recorded mouse trace, one frame per USB_JIG_IN_M_ENDP_POLLED_MS poll
+ * interval. Byte codes:
+ *   0x00        End of trace.
+ *   0b00xxxyyy  Frame with x, y delta -4..3 (3 bit two's complement).
+ *   0b01nnnnnn  Repeat previous frame deltas n + 1 times.
+ *   0b10nnnnnn  n + 1 frames without motion.
+ *   0b1100bwyx  Frame, followed by int8_t x, y, w deltas and uint8_t
+ *               button state for each set flag (in this order).
+ *   0xD0-0xFF   Reserved (end of trace).
+ * Button state holds until changed, wheel delta is 0 in short frames.
+ */
+#define MOUSE_TRACE_END 0x00
+#define MOUSE_TRACE_REPEAT 0x40
+#define MOUSE_TRACE_IDLE 0x80
+#define MOUSE_TRACE_FRAME 0xC0
+#define MOUSE_TRACE_FRAME_X 0x01
+#define MOUSE_TRACE_FRAME_Y 0x02
+#define MOUSE_TRACE_FRAME_W 0x04
+#define MOUSE_TRACE_FRAME_BM 0x08
+
+struct mouse_trace {
+	const uint8_t *data;
+	const uint8_t *p;
+	boolean_t loop;
+	int run;
+	struct mouse_report rep;
+};
+
+/**
+ * start_mouse_trace
+ *
+ * Starts playback of trace data (usually const table in flash). If loop is
+ * TRUE, trace is played repeatedly.
+ */
+void start_mouse_trace(struct mouse_trace *mt, const uint8_t *data, boolean_t loop);
+
+/**
+ * get_mouse_trace_report
+ *
+ * Decodes next frame into report. Returns FALSE at the end of trace.
+ */
+boolean_t get_mouse_trace_report(struct mouse_trace *mt, struct mouse_report *rep);
+
+#endif
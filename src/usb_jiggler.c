@@ -16,6 +16,7 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <string.h>
 #include <FreeRTOS.h>
 #include <task.h>
 #include <semphr.h>
@@ -32,15 +33,47 @@
 #include "tools.h"
 #include "usb_jiggler.h"
 
+#if USB_JIG_KEYB_IFACE == 1
+#define HID_IFACE_NMB 2
+#else
+#define HID_IFACE_NMB 1
+#endif
+// HID 1.11 7.2.4: recommended default idle rate is 500 ms for keyboards.
+#define KEYB_DFLT_IDLE_RATE (500 / 4)
+
+#define mem_barrier() __asm__ __volatile__ ("" ::: "memory")
+
+#if USB_LOG_MASK == 1
+#define LOG_MASK_SET_REQ_TYPE 0x40 // OUT, vendor, device.
+#define LOG_MASK_GET_REQ_TYPE 0xC0 // IN, vendor, device.
+#endif
+
+#if USB_JIG_LOG_TOKENS == 1
+// Arguments of message id (uint32_t), see USB_JIG_LOG_MSG_LIST.
+#define log_tok(id, ...) put_log_tok((id), (const uint32_t []) {__VA_ARGS__},\
+				     sizeof((const uint32_t []) {__VA_ARGS__}) / sizeof(uint32_t))
+#endif
+
+#if USB_JIG_LOG_TS == 1
+#define TS_FMT "+%u q%u "
+#define TS_ARGS(ts) log_ts_delta(ts), (unsigned int) (USB_JIG_TIMESTAMP() - (ts)),
+#define TS_TOK(ts) log_ts_delta(ts), USB_JIG_TIMESTAMP() - (ts)
+#else
+#define TS_FMT
+#define TS_ARGS(ts)
+#define TS_TOK(ts) 0, 0
+#endif
+
 struct mouse_report mouse_report;
 #if USB_JIG_KEYB_IFACE == 1
 struct keyb_report keyb_report;
-#if LOG_KEYB_LEDS == 1
-#define KEYB_LED_REPORT_QUE_SIZE 2
-QueueSetHandle_t keyb_led_rep_que;
-#endif
 #endif
+#define JIG_CTL_QSET_SIZE (UDP_EVNT_QUE_SIZE + JIGBTN_EVNT_QUE_SIZE)
 QueueSetHandle_t jig_ctl_qset;
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticQueue_t jig_ctl_qset_stc;
+static uint8_t jig_ctl_qset_buf[JIG_CTL_QSET_SIZE * sizeof(QueueSetMemberHandle_t)];
+#endif
 
 struct jig_conf_descs {
     struct usb_conf_desc conf_desc;
@@ -58,6 +91,9 @@ static const uint8_t m_rep_desc[] = {
     0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
     0x09, 0x02,                    // USAGE (Mouse)
     0xa1, 0x01,                    // COLLECTION (Application)
+#if USB_JIG_STATS_REP == 1
+    0x85, USB_JIG_M_REP_ID,        //   REPORT_ID (1)
+#endif
     0x09, 0x01,                    //   USAGE (Pointer)
     0xa1, 0x00,                    //   COLLECTION (Physical)
     0x05, 0x09,                    //     USAGE_PAGE (Button)
@@ -86,9 +122,30 @@ static const uint8_t m_rep_desc[] = {
     0x95, 0x01,                    //     REPORT_COUNT (1)
     0x81, 0x06,                    //     INPUT (Data,Var,Rel)
     0xc0,                          //   END_COLLECTION
+#if USB_JIG_STATS_REP == 1
+    0xc0,                          // END_COLLECTION
+    0x06, 0x00, 0xff,              // USAGE_PAGE (Vendor Defined Page 1)
+    0x09, 0x01,                    // USAGE (Vendor Usage 1)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, USB_JIG_STATS_REP_ID,    //   REPORT_ID (2)
+    0x09, 0x01,                    //   USAGE (Vendor Usage 1)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x26, 0xff, 0x00,              //   LOGICAL_MAXIMUM (255)
+    0x75, 0x08,                    //   REPORT_SIZE (8)
+    0x95, sizeof(struct usb_jig_stats_report) - 1, //   REPORT_COUNT (71)
+    0xb1, 0x02,                    //   FEATURE (Data,Var,Abs)
+#endif
     0xc0                           // END_COLLECTION
 };
 
+#if USB_JIG_MS_OS_20_DESC == 1
+// Hosts read BOS descriptor of device reporting bcdUSB 0x0201 or higher, 0x0210
+// (USB 2.1) is what they expect of BOS capable device.
+#define DEV_DESC_BCD_USB 0x0210
+#else
+#define DEV_DESC_BCD_USB USB_STD_USB2_00_VER_BCD
+#endif
+
 #if USB_JIG_KEYB_IFACE == 1
 static const uint8_t k_rep_desc[] = {
     0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
@@ -114,6 +171,17 @@ static const uint8_t k_rep_desc[] = {
     0x95, 0x01,                    //   REPORT_COUNT (1)
     0x75, 0x03,                    //   REPORT_SIZE (3)
     0x91, 0x03,                    //   OUTPUT (Cnst,Var,Abs)
+#if USB_JIG_KEYB_NKRO == 1
+    0x95, 0x78,                    //   REPORT_COUNT (120)
+    0x75, 0x01,                    //   REPORT_SIZE (1)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+    0x05, 0x07,                    //   USAGE_PAGE (Keyboard)
+    0x19, 0x00,                    //   USAGE_MINIMUM (Reserved (no event indicated))
+    0x29, 0x77,                    //   USAGE_MAXIMUM (Keyboard Select)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0xc0                           // END_COLLECTION
+#else
     0x95, 0x06,                    //   REPORT_COUNT (6)
     0x75, 0x08,                    //   REPORT_SIZE (8)
     0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
@@ -123,13 +191,14 @@ static const uint8_t k_rep_desc[] = {
     0x29, 0x65,                    //   USAGE_MAXIMUM (Keyboard Application)
     0x81, 0x00,                    //   INPUT (Data,Ary,Abs)
     0xc0                           // END_COLLECTION
+#endif
 };
 #endif
 
 static const struct usb_dev_desc dev_desc = {
 	.size = sizeof(struct usb_dev_desc),
 	.type = USB_DEV_DESC,
-	.bcd_usb = USB_STD_USB2_00_VER_BCD,
+	.bcd_usb = DEV_DESC_BCD_USB,
 	.b_device_class = 0,
 	.b_device_subclass = 0,
 	.b_device_protocol = 0,
@@ -143,74 +212,126 @@ static const struct usb_dev_desc dev_desc = {
 	.b_num_configurations = 1
 };
 
-static const struct jig_conf_descs conf_descs = {
-	{
-	.size = sizeof(struct usb_conf_desc),
-        .type = USB_CONF_DESC,
-        .w_total_size = sizeof(struct jig_conf_descs),
+/*
+ * Configuration descriptor set initializer, shared by configuration and
+ * other speed configuration descriptor (different type and endpoint
+ * polling interval encoding).
+ */
+#define conf_descs_init_m(desc_type, m_interval)\
+	{\
+	.size = sizeof(struct usb_conf_desc),\
+	.type = (desc_type),\
+	.w_total_size = sizeof(struct jig_conf_descs),\
+	.b_num_interfaces = HID_IFACE_NMB,\
+	.b_configuration_value = 1,\
+	.i_configuration = 0,\
+	.bm_attributes = USB_STD_BUS_POWER_NO_RWAKE,\
+	.b_max_power = usb_std_max_power_mamp(100)},\
+	{\
+	.size = sizeof(struct usb_iface_desc),\
+	.type = USB_IFACE_DESC,\
+	.b_interface_number = 0,\
+	.b_alternate_setting = 0,\
+	.b_num_endpoints = 1,\
+	.b_interface_class = USB_HID_CLASS,\
+	.b_interface_subclass = USB_HID_SUBCLASS_NO_BOOT,\
+	.b_interface_protocol = 0,\
+	.i_interface = 0},\
+	{\
+	.size = sizeof(struct usb_hid_desc),\
+	.type = USB_HID_DESC,\
+	.bcd_hid = USB_HID_REL_1_11_VER_BCD,\
+	.country_code = 0,\
+	.num_descs = 1,\
+	.rep_desc_type = USB_HID_REPORT_DESC,\
+	.rep_desc_size = sizeof(m_rep_desc)},\
+	{\
+	.size = sizeof(struct usb_endp_desc),\
+	.type = USB_ENDP_DESC,\
+	.b_endpoint_address = usb_std_endp_addr(USB_JIG_IN_M_ENDP_NUM, USB_STD_IN_ENDP),\
+	.bm_attributes = USB_STD_TRANS_INTERRUPT,\
+	.w_max_packet_size = USB_JIG_IN_M_ENDP_MAX_PKT_SIZE,\
+	.b_interval = (m_interval)}
+#define conf_descs_init_k(k_interval)\
+	{\
+	.size = sizeof(struct usb_iface_desc),\
+	.type = USB_IFACE_DESC,\
+	.b_interface_number = 1,\
+	.b_alternate_setting = 0,\
+	.b_num_endpoints = 1,\
+	.b_interface_class = USB_HID_CLASS,\
+	.b_interface_subclass = USB_HID_SUBCLASS_NO_BOOT,\
+	.b_interface_protocol = 0,\
+	.i_interface = 0},\
+	{\
+	.size = sizeof(struct usb_hid_desc),\
+	.type = USB_HID_DESC,\
+	.bcd_hid = USB_HID_REL_1_11_VER_BCD,\
+	.country_code = 0,\
+	.num_descs = 1,\
+	.rep_desc_type = USB_HID_REPORT_DESC,\
+	.rep_desc_size = sizeof(k_rep_desc)},\
+	{\
+	.size = sizeof(struct usb_endp_desc),\
+	.type = USB_ENDP_DESC,\
+	.b_endpoint_address = usb_std_endp_addr(USB_JIG_IN_K_ENDP_NUM, USB_STD_IN_ENDP),\
+	.bm_attributes = USB_STD_TRANS_INTERRUPT,\
+	.w_max_packet_size = USB_JIG_IN_K_ENDP_MAX_PKT_SIZE,\
+	.b_interval = (k_interval)}
 #if USB_JIG_KEYB_IFACE == 1
-        .b_num_interfaces = 2,
+#define conf_descs_init(desc_type, m_interval, k_interval)\
+	{conf_descs_init_m(desc_type, m_interval), conf_descs_init_k(k_interval)}
 #else
-	.b_num_interfaces = 1,
-#endif
-        .b_configuration_value = 1,
-        .i_configuration = 0,
-        .bm_attributes = USB_STD_BUS_POWER_NO_RWAKE,
-        .b_max_power = usb_std_max_power_mamp(100)},
-	{
-        .size = sizeof(struct usb_iface_desc),
-        .type = USB_IFACE_DESC,
-        .b_interface_number = 0,
-        .b_alternate_setting = 0,
-        .b_num_endpoints = 1,
-        .b_interface_class = USB_HID_CLASS,
-        .b_interface_subclass = USB_HID_SUBCLASS_NO_BOOT,
-	.b_interface_protocol = 0,
-        .i_interface = 0},
-	{
-        .size = sizeof(struct usb_hid_desc),
-        .type = USB_HID_DESC,
-        .bcd_hid = USB_HID_REL_1_11_VER_BCD,
-        .country_code = 0,
-        .num_descs = 1,
-        .rep_desc_type = USB_HID_REPORT_DESC,
-        .rep_desc_size = sizeof(m_rep_desc)},
-        {
-	.size = sizeof(struct usb_endp_desc),
-        .type = USB_ENDP_DESC,
-        .b_endpoint_address = usb_std_endp_addr(USB_JIG_IN_M_ENDP_NUM, USB_STD_IN_ENDP),
-        .bm_attributes = USB_STD_TRANS_INTERRUPT,
-        .w_max_packet_size = USB_JIG_IN_M_ENDP_MAX_PKT_SIZE,
-        .b_interval = USB_JIG_IN_M_ENDP_POLLED_MS},
-#if USB_JIG_KEYB_IFACE == 1
-	{
-        .size = sizeof(struct usb_iface_desc),
-        .type = USB_IFACE_DESC,
-        .b_interface_number = 1,
-        .b_alternate_setting = 0,
-        .b_num_endpoints = 1,
-        .b_interface_class = USB_HID_CLASS,
-        .b_interface_subclass = USB_HID_SUBCLASS_NO_BOOT,
-	.b_interface_protocol = 0,
-        .i_interface = 0},
-	{
-        .size = sizeof(struct usb_hid_desc),
-        .type = USB_HID_DESC,
-        .bcd_hid = USB_HID_REL_1_11_VER_BCD,
-        .country_code = 0,
-        .num_descs = 1,
-        .rep_desc_type = USB_HID_REPORT_DESC,
-        .rep_desc_size = sizeof(k_rep_desc)},
-        {
-	.size = sizeof(struct usb_endp_desc),
-        .type = USB_ENDP_DESC,
-        .b_endpoint_address = usb_std_endp_addr(USB_JIG_IN_K_ENDP_NUM, USB_STD_IN_ENDP),
-        .bm_attributes = USB_STD_TRANS_INTERRUPT,
-        .w_max_packet_size = USB_JIG_IN_K_ENDP_MAX_PKT_SIZE,
-        .b_interval = USB_JIG_IN_K_ENDP_POLLED_MS}
-#endif
+#define conf_descs_init(desc_type, m_interval, k_interval)\
+	{conf_descs_init_m(desc_type, m_interval)}
+#endif
+
+static const struct jig_conf_descs conf_descs =
+	conf_descs_init(USB_CONF_DESC, USB_JIG_IN_M_ENDP_POLLED_MS, USB_JIG_IN_K_ENDP_POLLED_MS);
+
+#if USB_JIG_DEV_QUAL_DESC == 1
+struct jig_dev_qual_desc {
+	uint8_t size;
+	uint8_t type;
+	uint16_t bcd_usb;
+	uint8_t b_device_class;
+	uint8_t b_device_subclass;
+	uint8_t b_device_protocol;
+	uint8_t b_max_packet_size0;
+	uint8_t b_num_configurations;
+	uint8_t b_reserved;
+} __attribute__ ((packed));
+
+static const struct jig_dev_qual_desc dev_qual_desc = {
+	.size = sizeof(struct jig_dev_qual_desc),
+	.type = USB_DEV_QUAL_DESC,
+	.bcd_usb = DEV_DESC_BCD_USB,
+	.b_device_class = 0,
+	.b_device_subclass = 0,
+	.b_device_protocol = 0,
+	.b_max_packet_size0 = 64,
+	.b_num_configurations = 1,
+	.b_reserved = 0
 };
 
+/*
+ * High-speed interrupt endpoint b_interval is exponent, period is
+ * 2^(b_interval - 1) microframes: b_interval = log2(ms) + 4 (ms rounded
+ * down to power of two).
+ */
+#define ms_log2(ms) ((ms) >= 128 ? 7 : (ms) >= 64 ? 6 : (ms) >= 32 ? 5 : (ms) >= 16 ? 4 :\
+		     (ms) >= 8 ? 3 : (ms) >= 4 ? 2 : (ms) >= 2 ? 1 : 0)
+#define hs_b_interval(ms) (ms_log2(ms) + 4)
+
+static const struct jig_conf_descs alt_speed_conf_descs =
+	conf_descs_init(USB_ALT_SPEED_CONF_DESC, hs_b_interval(USB_JIG_IN_M_ENDP_POLLED_MS),
+			hs_b_interval(USB_JIG_IN_K_ENDP_POLLED_MS));
+#endif
+
+// wIndex of string descriptor requests, from byte pair of language code.
+#define lang_id(code) lang_id_bytes(code)
+#define lang_id_bytes(lo, hi) ((hi) << 8 | (lo))
+
 static const uint8_t lang_str_desc[] = {
 	usb_std_str_desc_size(1),
         USB_STR_DESC,
@@ -259,11 +380,143 @@ static const uint8_t serial_str_desc[] = {
         usb_std_unicode('9')
 };
 
-static const uint8_t *str_desc_arry[] = {
-	lang_str_desc,
-	manufacturer_str_desc,
-	product_str_desc,
-	serial_str_desc
+#if USB_JIG_MS_OS_20_DESC == 1
+#define BOS_DESC 0x0F
+#define DEV_CAP_DESC 0x10
+#define DEV_CAP_USB2_EXT 0x02
+#define DEV_CAP_PLATFORM 0x05
+#define BOS_DESC_SIZE (5 + 7 + 28)
+#define MS_OS_20_DESC_INDEX 7
+#define MS_OS_20_DESC_REQ_TYPE 0xC0 // IN, vendor, device.
+#define MS_OS_20_SET_HEADER_DESC 0x00
+#define MS_OS_20_DESC_SET_SIZE 10
+#define MS_OS_20_WIN_VER_8_1 0x00, 0x00, 0x03, 0x06
+
+static const uint8_t bos_desc[] = {
+	5,                             // bLength
+	BOS_DESC,                      // bDescriptorType
+	BOS_DESC_SIZE & 0xFF,          // wTotalLength
+	BOS_DESC_SIZE >> 8,
+	2,                             // bNumDeviceCaps
+	7,                             // USB 2.0 Extension: bLength
+	DEV_CAP_DESC,                  //   bDescriptorType
+	DEV_CAP_USB2_EXT,              //   bDevCapabilityType
+	0x00, 0x00, 0x00, 0x00,        //   bmAttributes (no LPM)
+	28,                            // Platform: bLength
+	DEV_CAP_DESC,                  //   bDescriptorType
+	DEV_CAP_PLATFORM,              //   bDevCapabilityType
+	0x00,                          //   bReserved
+	0xDF, 0x60, 0xDD, 0xD8,        //   MS OS 2.0 PlatformCapabilityUUID
+	0x89, 0x45, 0xC7, 0x4C,        //   {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F}
+	0x9C, 0xD2, 0x65, 0x9D,
+	0x9E, 0x64, 0x8A, 0x9F,
+	MS_OS_20_WIN_VER_8_1,          //   dwWindowsVersion
+	MS_OS_20_DESC_SET_SIZE & 0xFF, //   wMSOSDescriptorSetTotalLength
+	MS_OS_20_DESC_SET_SIZE >> 8,
+	USB_JIG_MS_OS_20_VENDOR_CODE,  //   bMS_VendorCode
+	0x00                           //   bAltEnumCode
+};
+
+static const uint8_t ms_os_20_desc_set[] = {
+	MS_OS_20_DESC_SET_SIZE & 0xFF, // wLength
+	MS_OS_20_DESC_SET_SIZE >> 8,
+	MS_OS_20_SET_HEADER_DESC,      // wDescriptorType
+	0x00,
+	MS_OS_20_WIN_VER_8_1,          // dwWindowsVersion
+	MS_OS_20_DESC_SET_SIZE & 0xFF, // wTotalLength
+	MS_OS_20_DESC_SET_SIZE >> 8
+};
+#endif
+
+/*
+ * GET_DESCRIPTOR index: descriptor type selects row (separate row maps for
+ * device and interface recipient), descriptor index (device recipient) or
+ * interface number (interface recipient) selects column. Item holds the
+ * descriptor in flash and required w_index (language id of string
+ * descriptors, interface number of class descriptors). Rejected items are
+ * valid requests for unsupported descriptors, empty items are errors.
+ */
+enum desc_row {
+	DESC_ROW_NONE,
+	DESC_ROW_DEV,
+	DESC_ROW_CONF,
+	DESC_ROW_STR,
+	DESC_ROW_DEV_QUAL,
+	DESC_ROW_ALT_SPEED_CONF,
+	DESC_ROW_BOS,
+	DESC_ROW_HID_REP,
+	DESC_ROW_HID_PHYS,
+	DESC_ROW_NMB
+};
+
+#define DESC_COL_NMB 4
+#define DEV_DESC_TYPE_NMB 16
+#define IFC_DESC_TYPE_NMB 3
+
+#define desc_item(w_index, desc)\
+	{(const uint8_t *) &(desc), sizeof(desc), w_index, FALSE, 0}
+#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
+#define desc_rej_item(w_index, res)\
+	{NULL, 0, w_index, TRUE, res}
+#else
+#define desc_rej_item(w_index, res)\
+	{NULL, 0, w_index, TRUE, 0}
+#endif
+
+static const uint8_t dev_desc_rows[DEV_DESC_TYPE_NMB] = {
+	[USB_DEV_DESC] = DESC_ROW_DEV,
+	[USB_CONF_DESC] = DESC_ROW_CONF,
+	[USB_STR_DESC] = DESC_ROW_STR,
+	[USB_DEV_QUAL_DESC] = DESC_ROW_DEV_QUAL,
+	[USB_ALT_SPEED_CONF_DESC] = DESC_ROW_ALT_SPEED_CONF,
+#if USB_JIG_MS_OS_20_DESC == 1
+	[BOS_DESC] = DESC_ROW_BOS
+#endif
+};
+
+// Indexed by type - USB_HID_DESC.
+static const uint8_t ifc_desc_rows[IFC_DESC_TYPE_NMB] = {
+	[USB_HID_REPORT_DESC - USB_HID_DESC] = DESC_ROW_HID_REP,
+	[USB_HID_PHYSICAL_DESC - USB_HID_DESC] = DESC_ROW_HID_PHYS
+};
+
+static const struct desc_ref {
+	const uint8_t *buf;
+	uint16_t size;
+	uint16_t w_index;
+	boolean_t rej;
+	uint8_t res;
+} desc_refs[DESC_ROW_NMB][DESC_COL_NMB] = {
+	[DESC_ROW_DEV] = {desc_item(0, dev_desc)},
+	[DESC_ROW_CONF] = {desc_item(0, conf_descs)},
+	[DESC_ROW_STR] = {
+		desc_item(0, lang_str_desc),
+		desc_item(lang_id(USB_STD_EN_US_CODE), manufacturer_str_desc),
+		desc_item(lang_id(USB_STD_EN_US_CODE), product_str_desc),
+		desc_item(lang_id(USB_STD_EN_US_CODE), serial_str_desc)
+	},
+#if USB_JIG_DEV_QUAL_DESC == 1
+	[DESC_ROW_DEV_QUAL] = {desc_item(0, dev_qual_desc)},
+	[DESC_ROW_ALT_SPEED_CONF] = {desc_item(0, alt_speed_conf_descs)},
+#else
+	[DESC_ROW_DEV_QUAL] = {desc_rej_item(0, USB_JIG_CMD_RES_DEV_QUAL_UNSUP)},
+	[DESC_ROW_ALT_SPEED_CONF] = {desc_rej_item(0, USB_JIG_CMD_RES_ALT_SPEED_CONF_UNSUP)},
+#endif
+#if USB_JIG_MS_OS_20_DESC == 1
+	[DESC_ROW_BOS] = {desc_item(0, bos_desc)},
+#endif
+	[DESC_ROW_HID_REP] = {
+		desc_item(0, m_rep_desc),
+#if USB_JIG_KEYB_IFACE == 1
+		desc_item(1, k_rep_desc)
+#endif
+	},
+	[DESC_ROW_HID_PHYS] = {
+		desc_rej_item(0, USB_JIG_CMD_RES_HID_PHYS_UNSUP),
+#if USB_JIG_KEYB_IFACE == 1
+		desc_rej_item(1, USB_JIG_CMD_RES_HID_PHYS_UNSUP)
+#endif
+	}
 };
 
 static boolean_t is_self_powered(void);
@@ -279,9 +532,7 @@ static struct usb_ctl_req vnd_stp(struct usb_stp_pkt *sp);
 static void vnd_in_req_ack_clbk(void);
 static boolean_t vnd_out_req_rec_clbk(void);
 static void vnd_out_req_ack_clbk(void);
-static void std_get_desc_dev(struct usb_ctl_req *ucr);
-static void std_get_desc_ifc(struct usb_ctl_req *ucr);
-static boolean_t check_lng_code(uint16_t code);
+static void std_get_desc(struct usb_ctl_req *ucr);
 static void std_set_addr(struct usb_ctl_req *ucr);
 static void std_set_conf(struct usb_ctl_req *ucr);
 static void std_get_conf(struct usb_ctl_req *ucr);
@@ -302,14 +553,74 @@ static void cls_get_protocol(struct usb_ctl_req *ucr);
 static void cls_set_report(struct usb_ctl_req *ucr);
 static void cls_set_idle(struct usb_ctl_req *ucr);
 static void cls_set_protocol(struct usb_ctl_req *ucr);
+static void set_in_rpl(struct usb_ctl_req *ucr, const void *buf, int size);
 static boolean_t is_endp_index_valid(int w_index);
+static void count_req(enum usb_jig_req_res res);
+static void reset_idle_rates(void);
+static void set_idle_rate(int iface, uint8_t rate);
+#if USB_JIG_STATS_REP == 1
+static void fill_stats_report(struct usb_jig_stats_report *rep);
+static void stamp_rep_id(int iface, void *rep);
+#endif
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-static void log_std_cmd_event(const char *txt);
-static void log_cls_cmd_event(const char *txt);
+static void log_std_cmd_event(enum usb_jig_cmd_res res);
+static void log_cls_cmd_event(enum usb_jig_cmd_res res);
+static void log_vnd_cmd_event(enum usb_jig_cmd_res res);
+static void log_cmd_event(int8_t ctl_req_type, enum usb_jig_cmd_res res);
 #endif
 #if USB_LOG_CTL_REQ_STP_EVENTS == 1
 static void log_stp_event(struct usb_stp_pkt *stp);
 #endif
+#if USB_JIG_TMLN == 1
+static void add_tmln_item(enum usb_jig_tmln_evnt evnt);
+#if TERMOUT == 1
+static void log_tmln(void);
+#endif
+#endif
+#if USB_JIG_LOG_TOKENS == 1 &&\
+    (USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1 || TERMOUT == 1)
+static void put_log_tok(enum usb_jig_log_msg id, const uint32_t *arg, int n);
+#endif
+
+/*
+ * Standard requests: request code, log name and handlers for device,
+ * interface and endpoint recipient (NULL - request error). Class (HID)
+ * requests: request code and log name, all have interface recipient and are
+ * dispatched by switch in cls_stp() (direct calls are inlined, table made
+ * them about twice slower, see sim/bench_dispatch.c). Dispatch table and log
+ * name tables are generated from these lists.
+ */
+#define STD_CTL_REQ_LIST(X)\
+	X(USB_GET_STATUS, "get_stat", std_get_dev_stat, std_get_iface_stat, std_get_endp_stat)\
+	X(USB_CLEAR_FEATURE, "clr_feat", std_clr_dev_feat, std_clr_set_iface_feat, std_clr_set_endp_feat)\
+	X(USB_SET_FEATURE, "set_feat", std_set_dev_feat, std_clr_set_iface_feat, std_clr_set_endp_feat)\
+	X(USB_SET_ADDRESS, "set_addr", std_set_addr, NULL, NULL)\
+	X(USB_GET_DESCRIPTOR, "get_desc", std_get_desc, std_get_desc, NULL)\
+	X(USB_SET_DESCRIPTOR, "set_desc", std_set_desc, NULL, NULL)\
+	X(USB_GET_CONFIGURATION, "get_conf", std_get_conf, NULL, NULL)\
+	X(USB_SET_CONFIGURATION, "set_conf", std_set_conf, NULL, NULL)\
+	X(USB_GET_INTERFACE, "get_iface", NULL, std_get_iface, NULL)\
+	X(USB_SET_INTERFACE, "set_iface", NULL, std_set_iface, NULL)\
+	X(USB_SYNCH_FRAME, "sync_frm", NULL, NULL, std_synch_frm)
+
+#define CLS_CTL_REQ_LIST(X)\
+	X(USB_HID_GET_REPORT, "hid_get_report")\
+	X(USB_HID_GET_IDLE, "hid_get_idle")\
+	X(USB_HID_GET_PROTOCOL, "hid_get_protocol")\
+	X(USB_HID_SET_REPORT, "hid_set_report")\
+	X(USB_HID_SET_IDLE, "hid_set_idle")\
+	X(USB_HID_SET_PROTOCOL, "hid_set_protocol")
+
+#define CTL_REQ_RECP_NMB (USB_ENDP_RECIPIENT + 1)
+#define CTL_REQ_HNDLRS(code, name, dev, ifc, endp)\
+	[code] = {[USB_DEVICE_RECIPIENT] = dev, [USB_IFACE_RECIPIENT] = ifc, [USB_ENDP_RECIPIENT] = endp},
+#define CTL_REQ_NAME(code, name, ...) {code, name},
+
+typedef void ctl_req_hndlr_t(struct usb_ctl_req *ucr);
+
+static ctl_req_hndlr_t *const std_ctl_req_hndlrs[][CTL_REQ_RECP_NMB] = {
+	STD_CTL_REQ_LIST(CTL_REQ_HNDLRS)
+};
 
 static struct usb_ctl_req_clbks std_ctl_req_clbks = {
 	.stp_clbk = std_stp,
@@ -334,25 +645,126 @@ static struct usb_ctl_req_clbks vnd_ctl_req_clbks = {
 
 #if USB_JIG_KEYB_IFACE == 1
 static struct keyb_led_report keyb_led_report;
+#if LOG_KEYB_LEDS == 1
+/*
+ * Latest LED report, written by SET_REPORT data stage (single writer),
+ * seq is advanced after leds.
+ */
+static struct {
+	volatile uint32_t seq;
+	volatile uint8_t leds;
+} led_mbox;
+// Given on each update, wakes wait_keyb_led_report().
+static SemaphoreHandle_t led_sem;
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticSemaphore_t led_sem_stc;
+#endif
 #endif
+#endif
+/*
+ * Statistics. Writers (UDP interrupt or task code in critical section) advance
+ * stats_gen after each update, reader copies until stats_gen is unchanged.
+ */
 static struct usb_jiggler_stats stats;
+static volatile uint32_t stats_gen;
+static uint32_t bus_rst_ts;
+static boolean_t enum_tm_set;
 static struct usb_stp_pkt *stp_pkt;
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-static const char *req_err_str = "error";
-static const char *req_rej_str = "reject";
-static const char *req_done_str = "done";
+#if USB_LOG_CTL_REQ_CMD_EVENTS == 1 && USB_JIG_LOG_TOKENS == 0
+#define CMD_RES_TXT(id, txt) txt,
+
+static const char *const cmd_res_str[USB_JIG_CMD_RES_NMB] = {
+	USB_JIG_CMD_RES_LIST(CMD_RES_TXT)
+};
+#endif
+
+#if USB_JIG_TMLN == 1
+static struct usb_jig_tmln_item tmln[USB_JIG_TMLN_SIZE];
+static volatile int tmln_nmb;
+static boolean_t tmln_hid_get_report, tmln_hid_set_idle;
 #endif
 
+/*
+ * Published HID reports. Writer fills the slot which is not published and
+ * then advances sequence number (odd - write in progress). Slot published
+ * by sequence number s is slot[(s >> 1) & 1].
+ */
+static struct rep_store {
+	volatile uint32_t seq;
+	uint8_t slot[2][sizeof(union hid_report)];
+} rep_stores[HID_IFACE_NMB];
+
+static const uint8_t rep_size[HID_IFACE_NMB] = {
+	sizeof(struct mouse_report),
+#if USB_JIG_KEYB_IFACE == 1
+	sizeof(struct keyb_report)
+#endif
+};
+
+// Report ID of input report, first byte of report if not 0.
+static const uint8_t rep_id[HID_IFACE_NMB] = {
+#if USB_JIG_STATS_REP == 1
+	USB_JIG_M_REP_ID,
+#else
+	0,
+#endif
+#if USB_JIG_KEYB_IFACE == 1
+	0
+#endif
+};
+
 static union {
 	uint8_t conf;
 	uint16_t stat;
         uint8_t alt_iface;
+	uint8_t idle;
+	union hid_report rep;
+#if USB_JIG_STATS_REP == 1
+	struct usb_jig_stats_report stats_rep;
+#endif
 } ctl_rpl;
 
+/*
+ * HID idle rate (4 ms units, 0 - report only on change) set by SET_IDLE
+ * and time of the last interrupt IN report of each interface.
+ */
+#if USB_JIG_KEYB_IFACE == 1
+#define DFLT_IDLE_RATES {0, KEYB_DFLT_IDLE_RATE}
+#else
+#define DFLT_IDLE_RATES {0}
+#endif
+static const uint8_t dflt_idle_rate[HID_IFACE_NMB] = DFLT_IDLE_RATES;
+static volatile uint8_t idle_rate[HID_IFACE_NMB] = DFLT_IDLE_RATES;
+static TickType_t idle_rep_tm[HID_IFACE_NMB];
+
+/*
+ * Idle rate changes (sequence number and time) for is_hid_report_due(),
+ * new rate restarts idle period.
+ */
+static volatile uint8_t idle_chng_seq[HID_IFACE_NMB];
+static volatile TickType_t idle_chng_tm[HID_IFACE_NMB];
+static uint8_t idle_chng_seen[HID_IFACE_NMB];
+
+#if USB_JIG_HID_SUBMIT == 1
+static QueueHandle_t submit_que[HID_IFACE_NMB];
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticQueue_t submit_que_stc[HID_IFACE_NMB];
+static uint8_t submit_que_buf[HID_IFACE_NMB][USB_JIG_HID_SUBMIT_QUE_SIZE * sizeof(union hid_report)];
+#endif
+static SemaphoreHandle_t done_sem[HID_IFACE_NMB];
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticSemaphore_t done_sem_stc[HID_IFACE_NMB];
+#endif
+static void (*done_clbk[HID_IFACE_NMB])(int, void *);
+static void *done_clbk_arg[HID_IFACE_NMB];
+#endif
+
 #if USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1
 static logger_t usb_logger;
+#if USB_LOG_RING == 0
 static BaseType_t dmy;
 #endif
+#endif
 
 /**
  * init_usb_jiggler
@@ -361,17 +773,51 @@ void init_usb_jiggler(void)
 {
 	const struct usb_endp_desc *ed;
 	int ep;
+#if USB_JIG_HID_SUBMIT == 1
+	int i;
+#endif
 
-#if USB_JIG_KEYB_IFACE == 1 && LOG_KEYB_LEDS == 1
-	keyb_led_rep_que = xQueueCreate(KEYB_LED_REPORT_QUE_SIZE, sizeof(struct keyb_led_report));
-	if (keyb_led_rep_que == NULL) {
-		crit_err_exit(MALLOC_ERROR);
+#if USB_JIG_HID_SUBMIT == 1
+	for (i = 0; i < HID_IFACE_NMB; i++) {
+#if USB_JIG_STATIC_ALLOC == 1
+		submit_que[i] = xQueueCreateStatic(USB_JIG_HID_SUBMIT_QUE_SIZE, rep_size[i],
+						   submit_que_buf[i], &submit_que_stc[i]);
+#else
+		submit_que[i] = xQueueCreate(USB_JIG_HID_SUBMIT_QUE_SIZE, rep_size[i]);
+		if (submit_que[i] == NULL) {
+			crit_err_exit(MALLOC_ERROR);
+		}
+#endif
+#if USB_JIG_STATIC_ALLOC == 1
+		done_sem[i] = xSemaphoreCreateBinaryStatic(&done_sem_stc[i]);
+#else
+		done_sem[i] = xSemaphoreCreateBinary();
+		if (done_sem[i] == NULL) {
+			crit_err_exit(MALLOC_ERROR);
+		}
+#endif
+		// Nothing in flight.
+		xSemaphoreGive(done_sem[i]);
 	}
 #endif
-	jig_ctl_qset = xQueueCreateSet(UDP_EVNT_QUE_SIZE + JIGBTN_EVNT_QUE_SIZE);
+#if USB_JIG_STATIC_ALLOC == 1
+	jig_ctl_qset = xQueueCreateSetStatic(JIG_CTL_QSET_SIZE, jig_ctl_qset_buf, &jig_ctl_qset_stc);
+#else
+	jig_ctl_qset = xQueueCreateSet(JIG_CTL_QSET_SIZE);
 	if (jig_ctl_qset == NULL) {
 		crit_err_exit(MALLOC_ERROR);
 	}
+#endif
+#if USB_JIG_KEYB_IFACE == 1 && LOG_KEYB_LEDS == 1
+#if USB_JIG_STATIC_ALLOC == 1
+	led_sem = xSemaphoreCreateBinaryStatic(&led_sem_stc);
+#else
+	led_sem = xSemaphoreCreateBinary();
+	if (led_sem == NULL) {
+		crit_err_exit(MALLOC_ERROR);
+	}
+#endif
+#endif
 	add_usb_ctl_req_std_clbks(&std_ctl_req_clbks);
 	add_usb_ctl_req_cls_clbks(&cls_ctl_req_clbks);
         add_usb_ctl_req_vnd_clbks(&vnd_ctl_req_clbks);
@@ -423,259 +869,69 @@ static struct usb_ctl_req std_stp(struct usb_stp_pkt *sp)
 {
 	struct usb_ctl_req ucr = {.valid = FALSE};
 	enum usb_ctl_req_recp recp;
+	ctl_req_hndlr_t *hndlr;
 #if USB_LOG_CTL_REQ_STP_EVENTS == 1
 	log_stp_event(sp);
 #endif
 	stp_pkt = sp;
+#if USB_JIG_TMLN == 1
+	add_tmln_item(USB_JIG_TMLN_STD_STP);
+#endif
 	recp = stp_pkt->bm_request_type & 0x1F;
-        if (stp_pkt->b_request == USB_SET_DESCRIPTOR && recp == USB_DEVICE_RECIPIENT) {
-		std_set_desc(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_DESCRIPTOR && recp == USB_DEVICE_RECIPIENT) {
-		std_get_desc_dev(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_DESCRIPTOR && recp == USB_IFACE_RECIPIENT) {
-		std_get_desc_ifc(&ucr);
-	} else if (stp_pkt->b_request == USB_SET_ADDRESS && recp == USB_DEVICE_RECIPIENT) {
-		std_set_addr(&ucr);
-	} else if (stp_pkt->b_request == USB_SET_CONFIGURATION && recp == USB_DEVICE_RECIPIENT) {
-		std_set_conf(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_CONFIGURATION && recp == USB_DEVICE_RECIPIENT) {
-		std_get_conf(&ucr);
-	} else if (stp_pkt->b_request == USB_SET_INTERFACE && recp == USB_IFACE_RECIPIENT) {
-		std_set_iface(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_INTERFACE && recp == USB_IFACE_RECIPIENT) {
-		std_get_iface(&ucr);
-	} else if (stp_pkt->b_request == USB_SYNCH_FRAME && recp == USB_ENDP_RECIPIENT) {
-		std_synch_frm(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_STATUS && recp == USB_DEVICE_RECIPIENT) {
-		std_get_dev_stat(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_STATUS && recp == USB_IFACE_RECIPIENT) {
-		std_get_iface_stat(&ucr);
-	} else if (stp_pkt->b_request == USB_GET_STATUS && recp == USB_ENDP_RECIPIENT) {
-		std_get_endp_stat(&ucr);
-	} else if (stp_pkt->b_request == USB_CLEAR_FEATURE && recp == USB_DEVICE_RECIPIENT) {
-		std_clr_dev_feat(&ucr);
-	} else if (stp_pkt->b_request == USB_CLEAR_FEATURE && recp == USB_IFACE_RECIPIENT) {
-		std_clr_set_iface_feat(&ucr);
-	} else if (stp_pkt->b_request == USB_CLEAR_FEATURE && recp == USB_ENDP_RECIPIENT) {
-		std_clr_set_endp_feat(&ucr);
-	} else if (stp_pkt->b_request == USB_SET_FEATURE && recp == USB_DEVICE_RECIPIENT) {
-		std_set_dev_feat(&ucr);
-	} else if (stp_pkt->b_request == USB_SET_FEATURE && recp == USB_IFACE_RECIPIENT) {
-		std_clr_set_iface_feat(&ucr);
-	} else if (stp_pkt->b_request == USB_SET_FEATURE && recp == USB_ENDP_RECIPIENT) {
-		std_clr_set_endp_feat(&ucr);
+	if (stp_pkt->b_request < sizeof(std_ctl_req_hndlrs) / sizeof(std_ctl_req_hndlrs[0]) &&
+	    recp < CTL_REQ_RECP_NMB && (hndlr = std_ctl_req_hndlrs[stp_pkt->b_request][recp])) {
+		(*hndlr)(&ucr);
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 	return (ucr);
 }
 
 /**
- * std_get_desc_dev
+ * std_get_desc
  */
-static void std_get_desc_dev(struct usb_ctl_req *ucr)
+static void std_get_desc(struct usb_ctl_req *ucr)
 {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	const char *txt;
-#endif
-	switch (stp_pkt->w_value >> 8) {
-	case USB_DEV_DESC :
-		if ((stp_pkt->w_value & 0xFF) == 0 && stp_pkt->w_index == 0) {
-			ucr->valid = TRUE;
-			ucr->buf = (uint8_t *) &dev_desc;
-			if (stp_pkt->w_length > sizeof(dev_desc)) {
-				ucr->nmb = sizeof(dev_desc);
-			} else {
-				ucr->nmb = stp_pkt->w_length;
-			}
-			ucr->trans_nmb = stp_pkt->w_length;
-			ucr->trans_dir = UDP_CTL_TRANS_IN;
-			return;
-		} else {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
-#endif
-			stats.stp_err_cnt++;
-		}
-		break;
-	case USB_DEV_QUAL_DESC :
-		if ((stp_pkt->w_value & 0xFF) != 0 || stp_pkt->w_index != 0) {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
-#endif
-			stats.stp_err_cnt++;
-		} else {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = "dev_qual_desc unsupported";
-#endif
-			stats.stp_rej_cnt++;
-		}
-		break;
-	case USB_CONF_DESC :
-		if ((stp_pkt->w_value & 0xFF) == 0 && stp_pkt->w_index == 0) {
-			ucr->valid = TRUE;
-			ucr->buf = (uint8_t *) &conf_descs;
-			if (stp_pkt->w_length > sizeof(conf_descs)) {
-				ucr->nmb = sizeof(conf_descs);
-			} else {
-				ucr->nmb = stp_pkt->w_length;
-			}
-			ucr->trans_nmb = stp_pkt->w_length;
-			ucr->trans_dir = UDP_CTL_TRANS_IN;
-			return;
-		} else {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
-#endif
-			stats.stp_err_cnt++;
+	const struct desc_ref *dr;
+	enum usb_ctl_req_recp recp;
+	unsigned int type, idx, row = DESC_ROW_NONE;
+
+	recp = stp_pkt->bm_request_type & 0x1F;
+	type = stp_pkt->w_value >> 8;
+	idx = stp_pkt->w_value & 0xFF;
+	if (recp == USB_DEVICE_RECIPIENT) {
+		if (type < DEV_DESC_TYPE_NMB) {
+			row = dev_desc_rows[type];
 		}
-		break;
-	case USB_ALT_SPEED_CONF_DESC :
-		if ((stp_pkt->w_value & 0xFF) != 0 || stp_pkt->w_index != 0) {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
-#endif
-			stats.stp_err_cnt++;
-		} else {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = "alt_speed_conf_desc unsupported";
-#endif
-			stats.stp_rej_cnt++;
+	} else if (recp == USB_IFACE_RECIPIENT && idx == 0) {
+		if (type - USB_HID_DESC < IFC_DESC_TYPE_NMB) {
+			row = ifc_desc_rows[type - USB_HID_DESC];
 		}
-		break;
-	case USB_STR_DESC :
-		if ((stp_pkt->w_value & 0xFF) == 0) {
-			if (stp_pkt->w_index == 0) {
-				ucr->valid = TRUE;
-				ucr->buf = (uint8_t *) str_desc_arry[0];
-				if (stp_pkt->w_length > *str_desc_arry[0]) {
-					ucr->nmb = *str_desc_arry[0];
-				} else {
-					ucr->nmb = stp_pkt->w_length;
-				}
-				ucr->trans_nmb = stp_pkt->w_length;
-				ucr->trans_dir = UDP_CTL_TRANS_IN;
-				return;
-			}
-		} else {
-			uint8_t idx = stp_pkt->w_value;
-			if (idx < sizeof(str_desc_arry) / sizeof(const uint8_t *) &&
-			    check_lng_code(stp_pkt->w_index)) {
-				ucr->valid = TRUE;
-				ucr->buf = (uint8_t *) str_desc_arry[idx];
-				if (stp_pkt->w_length > *str_desc_arry[idx]) {
-					ucr->nmb = *str_desc_arry[idx];
-				} else {
-					ucr->nmb = stp_pkt->w_length;
-				}
-				ucr->trans_nmb = stp_pkt->w_length;
-				ucr->trans_dir = UDP_CTL_TRANS_IN;
+		idx = stp_pkt->w_index;
+	}
+	if (row != DESC_ROW_NONE && idx < DESC_COL_NMB) {
+		dr = &desc_refs[row][idx];
+		if (dr->w_index == stp_pkt->w_index) {
+			if (dr->buf) {
+				set_in_rpl(ucr, dr->buf, dr->size);
 				return;
 			}
-		}
-                /* FALLTHRU */
-	default :
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_err_str;
-#endif
-		stats.stp_err_cnt++;
-		break;
-	}
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(txt);
-#endif
-}
-
-/**
- * std_get_desc_ifc
- */
-static void std_get_desc_ifc(struct usb_ctl_req *ucr)
-{
+			if (dr->rej) {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	const char *txt;
+				log_std_cmd_event(dr->res);
 #endif
-	switch (stp_pkt->w_value >> 8) {
-	case USB_HID_REPORT_DESC :
-		if ((stp_pkt->w_value & 0xFF) == 0 && stp_pkt->w_index == 0) {
-			ucr->valid = TRUE;
-			ucr->buf = (uint8_t *) m_rep_desc;
-			if (stp_pkt->w_length > sizeof(m_rep_desc)) {
-				ucr->nmb = sizeof(m_rep_desc);
-			} else {
-				ucr->nmb = stp_pkt->w_length;
-			}
-			ucr->trans_nmb = stp_pkt->w_length;
-			ucr->trans_dir = UDP_CTL_TRANS_IN;
-			return;
-#if USB_JIG_KEYB_IFACE == 1
-		} else if ((stp_pkt->w_value & 0xFF) == 0 && stp_pkt->w_index == 1) {
-			ucr->valid = TRUE;
-			ucr->buf = (uint8_t *) k_rep_desc;
-			if (stp_pkt->w_length > sizeof(k_rep_desc)) {
-				ucr->nmb = sizeof(k_rep_desc);
-			} else {
-				ucr->nmb = stp_pkt->w_length;
+				count_req(USB_JIG_REQ_REJ);
+				return;
 			}
-			ucr->trans_nmb = stp_pkt->w_length;
-			ucr->trans_dir = UDP_CTL_TRANS_IN;
-			return;
-#endif
-		} else {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
-#endif
-			stats.stp_err_cnt++;
-		}
-		break;
-	case USB_HID_PHYSICAL_DESC :
-#if USB_JIG_KEYB_IFACE == 1
-		if (stp_pkt->w_index != 0 && stp_pkt->w_index != 1) {
-#else
-		if (stp_pkt->w_index != 0) {
-#endif
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
-#endif
-			stats.stp_err_cnt++;
-		} else {
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = "hid_physical_desc unsupported";
-#endif
-			stats.stp_rej_cnt++;
 		}
-		break;
-	default :
-#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_err_str;
-#endif
-		stats.stp_err_cnt++;
-		break;
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(txt);
+	log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-}
-
-/**
- * check_lng_code
- */
-static boolean_t check_lng_code(uint16_t code)
-{
-	union {
-		uint8_t lc_str[2];
-		uint16_t uint;
-	} lc;
-
-	lc.lc_str[0] = lang_str_desc[2];
-	lc.lc_str[1] = lang_str_desc[3];
-	if (lc.uint == code) {
-		return (TRUE);
-	} else {
-		return (FALSE);
-	}
+	count_req(USB_JIG_REQ_ERR);
 }
 
 /**
@@ -692,9 +948,9 @@ static void std_set_addr(struct usb_ctl_req *ucr)
 		ucr->trans_dir = UDP_CTL_TRANS_OUT;
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -747,9 +1003,9 @@ static void std_set_conf(struct usb_ctl_req *ucr)
 err_exit:
         ucr->valid = FALSE;
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(req_err_str);
+	log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-	stats.stp_err_cnt++;
+	count_req(USB_JIG_REQ_ERR);
 }
 
 /**
@@ -774,9 +1030,9 @@ static void std_get_conf(struct usb_ctl_req *ucr)
 		ucr->trans_dir = UDP_CTL_TRANS_IN;
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -787,22 +1043,22 @@ static void std_set_desc(struct usb_ctl_req *ucr)
 {
 	enum udp_state us;
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	const char *txt;
+	enum usb_jig_cmd_res res;
 #endif
 	us = get_udp_state();
         if (us == UDP_STATE_ADDRESSED || us == UDP_STATE_CONFIGURED) {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_rej_str;
+		res = USB_JIG_CMD_RES_REJ;
 #endif
-		stats.stp_rej_cnt++;
+		count_req(USB_JIG_REQ_REJ);
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_err_str;
+		res = USB_JIG_CMD_RES_ERR;
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(txt);
+	log_std_cmd_event(res);
 #endif
 }
 
@@ -813,22 +1069,22 @@ static void std_set_iface(struct usb_ctl_req *ucr)
 {
 	enum udp_state us;
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	const char *txt;
+	enum usb_jig_cmd_res res;
 #endif
 	us = get_udp_state();
         if (us == UDP_STATE_CONFIGURED && stp_pkt->w_length == 0) {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_rej_str;
+		res = USB_JIG_CMD_RES_REJ;
 #endif
-		stats.stp_rej_cnt++;
+		count_req(USB_JIG_REQ_REJ);
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_err_str;
+		res = USB_JIG_CMD_RES_ERR;
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(txt);
+	log_std_cmd_event(res);
 #endif
 }
 
@@ -851,9 +1107,9 @@ static void std_get_iface(struct usb_ctl_req *ucr)
 		ucr->trans_dir = UDP_CTL_TRANS_IN;
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -864,22 +1120,22 @@ static void std_synch_frm(struct usb_ctl_req *ucr)
 {
 	enum udp_state us;
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	const char *txt;
+	enum usb_jig_cmd_res res;
 #endif
 	us = get_udp_state();
         if (stp_pkt->w_value == 0 && stp_pkt->w_length == 2 && us == UDP_STATE_CONFIGURED) {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_rej_str;
+		res = USB_JIG_CMD_RES_REJ;
 #endif
-		stats.stp_rej_cnt++;
+		count_req(USB_JIG_REQ_REJ);
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_err_str;
+		res = USB_JIG_CMD_RES_ERR;
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(txt);
+	log_std_cmd_event(res);
 #endif
 }
 
@@ -907,9 +1163,9 @@ static void std_get_dev_stat(struct usb_ctl_req *ucr)
 		ucr->trans_dir = UDP_CTL_TRANS_IN;
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -932,9 +1188,9 @@ static void std_get_iface_stat(struct usb_ctl_req *ucr)
 		ucr->trans_dir = UDP_CTL_TRANS_IN;
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -967,9 +1223,9 @@ static void std_get_endp_stat(struct usb_ctl_req *ucr)
 		}
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(req_err_str);
+	log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-	stats.stp_err_cnt++;
+	count_req(USB_JIG_REQ_ERR);
 }
 
 /**
@@ -988,9 +1244,9 @@ static void std_clr_dev_feat(struct usb_ctl_req *ucr)
                 set_rmt_wkup_feat(FALSE);
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -1001,7 +1257,7 @@ static void std_set_dev_feat(struct usb_ctl_req *ucr)
 {
 	enum udp_state us;
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	const char *txt;
+	enum usb_jig_cmd_res res;
 #endif
 	us = get_udp_state();
 	if (stp_pkt->w_index == 0 && stp_pkt->w_length == 0) {
@@ -1013,23 +1269,23 @@ static void std_set_dev_feat(struct usb_ctl_req *ucr)
 			return;
 		} else if (stp_pkt->w_value == USB_TEST_MODE_FEAT) {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_rej_str;
+			res = USB_JIG_CMD_RES_REJ;
 #endif
-                        stats.stp_rej_cnt++;
+                        count_req(USB_JIG_REQ_REJ);
 		} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-			txt = req_err_str;
+			res = USB_JIG_CMD_RES_ERR;
 #endif
-                        stats.stp_err_cnt++;
+                        count_req(USB_JIG_REQ_ERR);
 		}
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		txt = req_err_str;
+		res = USB_JIG_CMD_RES_ERR;
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(txt);
+	log_std_cmd_event(res);
 #endif
 }
 
@@ -1039,9 +1295,9 @@ static void std_set_dev_feat(struct usb_ctl_req *ucr)
 static void std_clr_set_iface_feat(struct usb_ctl_req *ucr)
 {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(req_rej_str);
+	log_std_cmd_event(USB_JIG_CMD_RES_REJ);
 #endif
-	stats.stp_rej_cnt++;
+	count_req(USB_JIG_REQ_REJ);
 }
 
 /**
@@ -1066,9 +1322,9 @@ static void std_clr_set_endp_feat(struct usb_ctl_req *ucr)
 		}
 	} else {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_err_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
+		count_req(USB_JIG_REQ_ERR);
 	}
 }
 
@@ -1085,8 +1341,9 @@ static void std_in_req_ack_clbk(void)
         case USB_GET_CONFIGURATION :
 		/* FALLTHRU */
         case USB_GET_INTERFACE :
+		count_req(USB_JIG_REQ_DONE);
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_std_cmd_event(req_done_str);
+		log_std_cmd_event(USB_JIG_CMD_RES_DONE);
 #endif
 		break;
 	}
@@ -1108,9 +1365,22 @@ static void std_out_req_ack_clbk(void)
 	switch (stp_pkt->b_request) {
 	case USB_SET_ADDRESS :
 		set_udp_addr(stp_pkt->w_value);
+#if USB_JIG_TMLN == 1
+		add_tmln_item(USB_JIG_TMLN_SET_ADDR);
+#endif
 		break;
         case USB_SET_CONFIGURATION :
-		/* FALLTHRU */
+		reset_idle_rates();
+		// First configuration after bus reset only.
+		if ((stp_pkt->w_value & 0xFF) && !enum_tm_set) {
+			enum_tm_set = TRUE;
+			stats.enum_tm = USB_JIG_TIMESTAMP() - bus_rst_ts;
+			stats_gen++;
+		}
+#if USB_JIG_TMLN == 1
+		add_tmln_item(USB_JIG_TMLN_SET_CONF);
+#endif
+		/* FALLTHRU */
 	case USB_CLEAR_FEATURE :
                 /* FALLTHRU */
 	case USB_SET_FEATURE :
@@ -1118,8 +1388,9 @@ static void std_out_req_ack_clbk(void)
 	default :
 		return;
 	}
+	count_req(USB_JIG_REQ_DONE);
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_std_cmd_event(req_done_str);
+	log_std_cmd_event(USB_JIG_CMD_RES_DONE);
 #endif
 }
 
@@ -1135,25 +1406,44 @@ static struct usb_ctl_req cls_stp(struct usb_stp_pkt *sp)
 	log_stp_event(sp);
 #endif
 	stp_pkt = sp;
+#if USB_JIG_TMLN == 1
+	if (stp_pkt->b_request == USB_HID_GET_REPORT && !tmln_hid_get_report) {
+		tmln_hid_get_report = TRUE;
+		add_tmln_item(USB_JIG_TMLN_HID_GET_REPORT);
+	} else if (stp_pkt->b_request == USB_HID_SET_IDLE && !tmln_hid_set_idle) {
+		tmln_hid_set_idle = TRUE;
+		add_tmln_item(USB_JIG_TMLN_HID_SET_IDLE);
+	}
+#endif
 	recp = stp_pkt->bm_request_type & 0x1F;
-	if (stp_pkt->b_request == USB_HID_GET_REPORT && recp == USB_IFACE_RECIPIENT) {
-		cls_get_report(&ucr);
-	} else if (stp_pkt->b_request == USB_HID_GET_IDLE && recp == USB_IFACE_RECIPIENT) {
-		cls_get_idle(&ucr);
-	} else if (stp_pkt->b_request == USB_HID_GET_PROTOCOL && recp == USB_IFACE_RECIPIENT) {
-		cls_get_protocol(&ucr);
-	} else if (stp_pkt->b_request ==  USB_HID_SET_REPORT && recp == USB_IFACE_RECIPIENT) {
-		cls_set_report(&ucr);
-	} else if (stp_pkt->b_request ==  USB_HID_SET_IDLE && recp == USB_IFACE_RECIPIENT) {
-		cls_set_idle(&ucr);
-	} else if (stp_pkt->b_request ==  USB_HID_SET_PROTOCOL && recp == USB_IFACE_RECIPIENT) {
-		cls_set_protocol(&ucr);
-	} else {
+	if (recp == USB_IFACE_RECIPIENT) {
+		switch (stp_pkt->b_request) {
+		case USB_HID_GET_REPORT :
+			cls_get_report(&ucr);
+			return (ucr);
+		case USB_HID_GET_IDLE :
+			cls_get_idle(&ucr);
+			return (ucr);
+		case USB_HID_GET_PROTOCOL :
+			cls_get_protocol(&ucr);
+			return (ucr);
+		case USB_HID_SET_REPORT :
+			cls_set_report(&ucr);
+			return (ucr);
+		case USB_HID_SET_IDLE :
+			cls_set_idle(&ucr);
+			return (ucr);
+		case USB_HID_SET_PROTOCOL :
+			cls_set_protocol(&ucr);
+			return (ucr);
+		default :
+			break;
+		}
+	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	        log_cls_cmd_event(req_err_str);
+        log_cls_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-		stats.stp_err_cnt++;
-	}
+	count_req(USB_JIG_REQ_ERR);
 	return (ucr);
 }
 
@@ -1165,38 +1455,28 @@ static void cls_get_report(struct usb_ctl_req *ucr)
 	enum udp_state us;
 
 	us = get_udp_state();
-	if ((stp_pkt->w_value >> 8) == USB_HID_REPORT_IN && (stp_pkt->w_value & 0xFF) == 0 &&
-	    us == UDP_STATE_CONFIGURED) {
-		if (stp_pkt->w_index == 0) {
-			ucr->valid = TRUE;
-			ucr->buf = (uint8_t *) &mouse_report;
-			if (stp_pkt->w_length > sizeof(struct mouse_report)) {
-				ucr->nmb = sizeof(struct mouse_report);
-			} else {
-				ucr->nmb = stp_pkt->w_length;
-			}
-			ucr->trans_nmb = stp_pkt->w_length;
-			ucr->trans_dir = UDP_CTL_TRANS_IN;
+	if ((stp_pkt->w_value >> 8) == USB_HID_REPORT_IN && us == UDP_STATE_CONFIGURED) {
+		if (stp_pkt->w_index < HID_IFACE_NMB &&
+		    (stp_pkt->w_value & 0xFF) == rep_id[stp_pkt->w_index]) {
+			// Writer task can not run in ISR, published slot is stable.
+			struct rep_store *rs = &rep_stores[stp_pkt->w_index];
+			memcpy(&ctl_rpl.rep, rs->slot[(rs->seq >> 1) & 1], rep_size[stp_pkt->w_index]);
+			set_in_rpl(ucr, &ctl_rpl.rep, rep_size[stp_pkt->w_index]);
 			return;
-#if USB_JIG_KEYB_IFACE == 1
-		} else if (stp_pkt->w_index == 1) {
-			ucr->valid = TRUE;
-			ucr->buf = (uint8_t *) &keyb_report;
-			if (stp_pkt->w_length > sizeof(struct keyb_report)) {
-				ucr->nmb = sizeof(struct keyb_report);
-			} else {
-				ucr->nmb = stp_pkt->w_length;
-			}
-			ucr->trans_nmb = stp_pkt->w_length;
-			ucr->trans_dir = UDP_CTL_TRANS_IN;
-			return;
-#endif
 		}
 	}
+#if USB_JIG_STATS_REP == 1
+	if (stp_pkt->w_value == (USB_HID_REPORT_FEATURE << 8 | USB_JIG_STATS_REP_ID) &&
+	    stp_pkt->w_index == USB_JIG_M_IFACE && us == UDP_STATE_CONFIGURED) {
+		fill_stats_report(&ctl_rpl.stats_rep);
+		set_in_rpl(ucr, &ctl_rpl.stats_rep, sizeof(ctl_rpl.stats_rep));
+		return;
+	}
+#endif
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_err_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-	stats.stp_err_cnt++;
+	count_req(USB_JIG_REQ_ERR);
 }
 
 /**
@@ -1205,30 +1485,22 @@ static void cls_get_report(struct usb_ctl_req *ucr)
 static void cls_get_idle(struct usb_ctl_req *ucr)
 {
 	enum udp_state us;
-	static uint8_t rpl;
 
 	us = get_udp_state();
-	if (stp_pkt->w_value == 0 && stp_pkt->w_length == 1 && us == UDP_STATE_CONFIGURED) {
-		ucr->buf = &rpl;
+	if (stp_pkt->w_value == 0 && stp_pkt->w_length == 1 && stp_pkt->w_index < HID_IFACE_NMB &&
+	    us == UDP_STATE_CONFIGURED) {
+		ctl_rpl.idle = idle_rate[stp_pkt->w_index];
+		ucr->valid = TRUE;
+		ucr->buf = (uint8_t *) &ctl_rpl;
 		ucr->nmb = 1;
 		ucr->trans_nmb = 1;
 		ucr->trans_dir = UDP_CTL_TRANS_IN;
-		if (stp_pkt->w_index == 0) {
-			rpl = 0;
-			ucr->valid = TRUE;
-                        return;
-#if USB_JIG_KEYB_IFACE == 1
-		} else if (stp_pkt->w_index == 1) {
-			rpl = 0;
-			ucr->valid = TRUE;
-                        return;
-#endif
-		}
+		return;
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_err_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-	stats.stp_err_cnt++;
+	count_req(USB_JIG_REQ_ERR);
 }
 
 /**
@@ -1237,9 +1509,9 @@ static void cls_get_idle(struct usb_ctl_req *ucr)
 static void cls_get_protocol(struct usb_ctl_req *ucr)
 {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_rej_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_REJ);
 #endif
-	stats.stp_rej_cnt++;
+	count_req(USB_JIG_REQ_REJ);
 }
 
 /**
@@ -1261,14 +1533,14 @@ static void cls_set_report(struct usb_ctl_req *ucr)
 		return;
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_err_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-	stats.stp_err_cnt++;
+	count_req(USB_JIG_REQ_ERR);
 #else
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_rej_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_REJ);
 #endif
-	stats.stp_rej_cnt++;
+	count_req(USB_JIG_REQ_REJ);
 #endif
 }
 
@@ -1280,23 +1552,17 @@ static void cls_set_idle(struct usb_ctl_req *ucr)
 	enum udp_state us;
 
 	us = get_udp_state();
-	if ((stp_pkt->w_value == 0 && stp_pkt->w_length == 0 && us == UDP_STATE_CONFIGURED)) {
-		if (stp_pkt->w_index == 0) {
-			ucr->valid = TRUE;
-			ucr->trans_dir = UDP_CTL_TRANS_OUT;
-                        return;
-#if USB_JIG_KEYB_IFACE == 1
-		} else if (stp_pkt->w_index == 1) {
-			ucr->valid = TRUE;
-			ucr->trans_dir = UDP_CTL_TRANS_OUT;
-                        return;
-#endif
-		}
+	if ((stp_pkt->w_value & 0xFF) == 0 && stp_pkt->w_length == 0 &&
+	    stp_pkt->w_index < HID_IFACE_NMB && us == UDP_STATE_CONFIGURED) {
+		set_idle_rate(stp_pkt->w_index, stp_pkt->w_value >> 8);
+		ucr->valid = TRUE;
+		ucr->trans_dir = UDP_CTL_TRANS_OUT;
+		return;
 	}
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_err_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_ERR);
 #endif
-	stats.stp_err_cnt++;
+	count_req(USB_JIG_REQ_ERR);
 }
 
 /**
@@ -1305,9 +1571,9 @@ static void cls_set_idle(struct usb_ctl_req *ucr)
 static void cls_set_protocol(struct usb_ctl_req *ucr)
 {
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-	log_cls_cmd_event(req_rej_str);
+	log_cls_cmd_event(USB_JIG_CMD_RES_REJ);
 #endif
-	stats.stp_rej_cnt++;
+	count_req(USB_JIG_REQ_REJ);
 }
 
 /**
@@ -1319,8 +1585,9 @@ static void cls_in_req_ack_clbk(void)
 	case USB_HID_GET_REPORT :
 		/* FALLTHRU */
 	case USB_HID_GET_IDLE :
+		count_req(USB_JIG_REQ_DONE);
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_cls_cmd_event(req_done_str);
+		log_cls_cmd_event(USB_JIG_CMD_RES_DONE);
 #endif
 		break;
 	}
@@ -1331,11 +1598,18 @@ static void cls_in_req_ack_clbk(void)
  */
 static boolean_t cls_out_req_rec_clbk(void)
 {
+#if USB_JIG_KEYB_IFACE == 1 && LOG_KEYB_LEDS == 1
+	BaseType_t hpw;
+#endif
+
 	switch (stp_pkt->b_request) {
 #if USB_JIG_KEYB_IFACE == 1
 	case USB_HID_SET_REPORT :
 #if LOG_KEYB_LEDS == 1
-		xQueueSendFromISR(keyb_led_rep_que, &keyb_led_report, NULL);
+		led_mbox.leds = keyb_led_report.leds;
+		mem_barrier();
+		led_mbox.seq++;
+		xSemaphoreGiveFromISR(led_sem, &hpw);
 #endif
 		return (TRUE);
 #endif
@@ -1354,8 +1628,9 @@ static void cls_out_req_ack_clbk(void)
 	case USB_HID_SET_REPORT :
 		/* FALLTHRU */
 	case USB_HID_SET_IDLE :
+		count_req(USB_JIG_REQ_DONE);
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		log_cls_cmd_event(req_done_str);
+		log_cls_cmd_event(USB_JIG_CMD_RES_DONE);
 #endif
 		break;
 #endif
@@ -1369,7 +1644,39 @@ static void cls_out_req_ack_clbk(void)
  */
 static struct usb_ctl_req vnd_stp(struct usb_stp_pkt *sp)
 {
-	return ((struct usb_ctl_req){.valid = FALSE});
+	struct usb_ctl_req ucr = {.valid = FALSE};
+
+#if USB_LOG_CTL_REQ_STP_EVENTS == 1
+	log_stp_event(sp);
+#endif
+	stp_pkt = sp;
+#if USB_JIG_MS_OS_20_DESC == 1
+	if (stp_pkt->b_request == USB_JIG_MS_OS_20_VENDOR_CODE &&
+	    stp_pkt->bm_request_type == MS_OS_20_DESC_REQ_TYPE &&
+	    stp_pkt->w_value == 0 && stp_pkt->w_index == MS_OS_20_DESC_INDEX) {
+		set_in_rpl(&ucr, ms_os_20_desc_set, sizeof(ms_os_20_desc_set));
+		return (ucr);
+	}
+#endif
+#if USB_LOG_MASK == 1
+	if (stp_pkt->b_request == USB_JIG_LOG_MASK_VENDOR_CODE && stp_pkt->w_index == 0) {
+		if (stp_pkt->bm_request_type == LOG_MASK_SET_REQ_TYPE && stp_pkt->w_length == 0) {
+			set_usb_log_mask(stp_pkt->w_value);
+			ucr.valid = TRUE;
+			ucr.trans_dir = UDP_CTL_TRANS_OUT;
+			return (ucr);
+		} else if (stp_pkt->bm_request_type == LOG_MASK_GET_REQ_TYPE) {
+			ctl_rpl.stat = usb_log_mask;
+			set_in_rpl(&ucr, &ctl_rpl.stat, sizeof(ctl_rpl.stat));
+			return (ucr);
+		}
+	}
+#endif
+#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
+	log_vnd_cmd_event(USB_JIG_CMD_RES_ERR);
+#endif
+	count_req(USB_JIG_REQ_ERR);
+	return (ucr);
 }
 
 /**
@@ -1377,6 +1684,10 @@ static struct usb_ctl_req vnd_stp(struct usb_stp_pkt *sp)
  */
 static void vnd_in_req_ack_clbk(void)
 {
+	count_req(USB_JIG_REQ_DONE);
+#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
+	log_vnd_cmd_event(USB_JIG_CMD_RES_DONE);
+#endif
 }
 
 /**
@@ -1392,8 +1703,105 @@ static boolean_t vnd_out_req_rec_clbk(void)
  */
 static void vnd_out_req_ack_clbk(void)
 {
+	count_req(USB_JIG_REQ_DONE);
+#if USB_LOG_CTL_REQ_CMD_EVENTS == 1
+	log_vnd_cmd_event(USB_JIG_CMD_RES_DONE);
+#endif
 }
 
+/**
+ * set_in_rpl
+ */
+static void set_in_rpl(struct usb_ctl_req *ucr, const void *buf, int size)
+{
+	ucr->valid = TRUE;
+	ucr->buf = (uint8_t *) buf;
+	if (stp_pkt->w_length > size) {
+		ucr->nmb = size;
+	} else {
+		ucr->nmb = stp_pkt->w_length;
+	}
+	ucr->trans_nmb = stp_pkt->w_length;
+	ucr->trans_dir = UDP_CTL_TRANS_IN;
+}
+
+/**
+ * count_req
+ */
+static void count_req(enum usb_jig_req_res res)
+{
+	int code;
+
+	code = stp_pkt->b_request;
+	switch ((stp_pkt->bm_request_type >> 5) & 3) {
+	case USB_STANDARD_REQUEST :
+		if (code > USB_JIG_STD_REQ_NMB) {
+			code = USB_JIG_STD_REQ_NMB;
+		}
+		stats.std_req_cnt[code][res]++;
+		break;
+	case USB_CLASS_REQUEST :
+		if (code > USB_JIG_CLS_REQ_NMB) {
+			code = USB_JIG_CLS_REQ_NMB;
+		}
+		stats.cls_req_cnt[code][res]++;
+		break;
+	default :
+		stats.vnd_req_cnt[res]++;
+		break;
+	}
+	if (res == USB_JIG_REQ_ERR) {
+		stats.stp_err_cnt++;
+	} else if (res == USB_JIG_REQ_REJ) {
+		stats.stp_rej_cnt++;
+	}
+	mem_barrier();
+	stats_gen++;
+}
+
+#if USB_JIG_STATS_REP == 1
+/**
+ * fill_stats_report
+ */
+static void fill_stats_report(struct usb_jig_stats_report *rep)
+{
+	int i, j;
+
+	// Called in UDP interrupt, task side writers are excluded.
+	memset(rep, 0, sizeof(struct usb_jig_stats_report));
+	rep->id = USB_JIG_STATS_REP_ID;
+	rep->ver = USB_JIG_STATS_REP_VER;
+	rep->ts = USB_JIG_TIMESTAMP();
+	rep->enum_tm = stats.enum_tm;
+	rep->stp_err_cnt = stats.stp_err_cnt;
+	rep->stp_rej_cnt = stats.stp_rej_cnt;
+	for (i = 0; i < USB_JIG_REQ_RES_NMB; i++) {
+		for (j = 0; j <= USB_JIG_STD_REQ_NMB; j++) {
+			rep->req_cnt[0][i] += stats.std_req_cnt[j][i];
+		}
+		for (j = 0; j <= USB_JIG_CLS_REQ_NMB; j++) {
+			rep->req_cnt[1][i] += stats.cls_req_cnt[j][i];
+		}
+		rep->req_cnt[2][i] = stats.vnd_req_cnt[i];
+	}
+	for (i = 0; i < HID_IFACE_NMB; i++) {
+		rep->in_rep_cnt[i] = stats.in_rep_cnt[i];
+	}
+	rep->bus_rst_cnt = stats.bus_rst_cnt;
+	rep->suspend_cnt = stats.suspend_cnt;
+}
+
+/**
+ * stamp_rep_id
+ */
+static void stamp_rep_id(int iface, void *rep)
+{
+	if (rep_id[iface]) {
+		*(uint8_t *) rep = rep_id[iface];
+	}
+}
+#endif
+
 /**
  * is_endp_index_valid
  */
@@ -1419,29 +1827,14 @@ static boolean_t is_endp_index_valid(int w_index)
 	return (FALSE);
 }
 
-#if USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1
+#if (USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1) && USB_JIG_LOG_TOKENS == 0
 static const struct txt_item std_ctl_req_code_str_arry[] = {
-	{USB_GET_STATUS, "get_stat"},
-	{USB_CLEAR_FEATURE, "clr_feat"},
-	{USB_SET_FEATURE, "set_feat"},
-	{USB_SET_ADDRESS, "set_addr"},
-	{USB_GET_DESCRIPTOR, "get_desc"},
-	{USB_SET_DESCRIPTOR, "set_desc"},
-	{USB_GET_CONFIGURATION, "get_conf"},
-	{USB_SET_CONFIGURATION, "set_conf"},
-	{USB_GET_INTERFACE, "get_iface"},
-	{USB_SET_INTERFACE, "set_iface"},
-	{USB_SYNCH_FRAME, "sync_frm"},
+	STD_CTL_REQ_LIST(CTL_REQ_NAME)
 	{0, NULL}
 };
 
 static const struct txt_item cls_ctl_req_code_str_arry[] = {
-	{USB_HID_GET_REPORT, "hid_get_report"},
-	{USB_HID_GET_IDLE, "hid_get_idle"},
-	{USB_HID_GET_PROTOCOL, "hid_get_protocol"},
-	{USB_HID_SET_REPORT, "hid_set_report"},
-	{USB_HID_SET_IDLE, "hid_set_idle"},
-	{USB_HID_SET_PROTOCOL, "hid_set_protocol"},
+	CLS_CTL_REQ_LIST(CTL_REQ_NAME)
 	{0, NULL}
 };
 
@@ -1454,6 +1847,55 @@ static const struct txt_item ctl_req_recp_str_arry[] = {
 };
 #endif
 
+#if (USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1) && USB_JIG_LOG_TS == 1
+/**
+ * log_ts_delta
+ *
+ * Returns time from previous formatted event (log task).
+ */
+static unsigned int log_ts_delta(uint32_t ts)
+{
+	static uint32_t prev_ts;
+	uint32_t d;
+
+	d = ts - prev_ts;
+	prev_ts = ts;
+	return (d);
+}
+#endif
+
+#if USB_JIG_LOG_TOKENS == 1 &&\
+    (USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1 || TERMOUT == 1)
+/**
+ * put_log_tok
+ *
+ * Prints message id and n arguments as hex bytes of LEB128 numbers, no
+ * number formatting is done by msg().
+ */
+static void put_log_tok(enum usb_jig_log_msg id, const uint32_t *arg, int n)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char buf[2 * 5 * (1 + USB_JIG_LOG_TOK_MAX_ARGS) + 1];
+	uint32_t v;
+	uint8_t b;
+	int i, j = 0;
+
+	for (i = -1; i < n; i++) {
+		v = (i < 0) ? (uint32_t) id : arg[i];
+		do {
+			b = v & 0x7F;
+			if ((v >>= 7)) {
+				b |= 0x80;
+			}
+			buf[j++] = hex[b >> 4];
+			buf[j++] = hex[b & 0x0F];
+		} while (v);
+	}
+	buf[j] = '\0';
+	msg(INF, "usb_jiggler.c: @%s\n", buf);
+}
+#endif
+
 #if USB_LOG_CTL_REQ_STP_EVENTS == 1
 /**
  * fmt_usb_ctl_req_stp_event
@@ -1461,26 +1903,54 @@ static const struct txt_item ctl_req_recp_str_arry[] = {
 static void fmt_usb_ctl_req_stp_event(struct usb_ctl_req_stp_event *p);
 static void fmt_usb_ctl_req_stp_event(struct usb_ctl_req_stp_event *p)
 {
+#if USB_JIG_LOG_TOKENS == 1
+	log_tok(USB_JIG_LOG_MSG_STP, p->stp_pkt.bm_request_type, p->stp_pkt.b_request,
+		p->stp_pkt.w_value, p->stp_pkt.w_index, p->stp_pkt.w_length, TS_TOK(p->ts));
+#else
 	if (((p->stp_pkt.bm_request_type >> 5) & 3) == USB_STANDARD_REQUEST) {
-		msg(INF, "usb_jiggler.c: %sstd[%s] rcp=%s val=0x%.4hX ind=0x%.4hX len=%hu\n",
-		    (p->stp_pkt.bm_request_type & (1 << 7)) ? ">" : "<",
+		msg(INF, "usb_jiggler.c: " TS_FMT "%sstd[%s] rcp=%s val=0x%.4hX ind=0x%.4hX len=%hu\n",
+		    TS_ARGS(p->ts) (p->stp_pkt.bm_request_type & (1 << 7)) ? ">" : "<",
 		    find_txt_item(p->stp_pkt.b_request, std_ctl_req_code_str_arry, "undef"),
 		    find_txt_item(p->stp_pkt.bm_request_type & 0x1F, ctl_req_recp_str_arry, "undef"),
 		    p->stp_pkt.w_value, p->stp_pkt.w_index, p->stp_pkt.w_length);
 	} else if (((p->stp_pkt.bm_request_type >> 5) & 3) == USB_CLASS_REQUEST) {
-		msg(INF, "usb_jiggler.c: %scls[%s] rcp=%s val=0x%.4hX ind=0x%.4hX len=%hu\n",
-		    (p->stp_pkt.bm_request_type & (1 << 7)) ? ">" : "<",
+		msg(INF, "usb_jiggler.c: " TS_FMT "%scls[%s] rcp=%s val=0x%.4hX ind=0x%.4hX len=%hu\n",
+		    TS_ARGS(p->ts) (p->stp_pkt.bm_request_type & (1 << 7)) ? ">" : "<",
 		    find_txt_item(p->stp_pkt.b_request, cls_ctl_req_code_str_arry, "undef"),
 		    find_txt_item(p->stp_pkt.bm_request_type & 0x1F, ctl_req_recp_str_arry, "undef"),
 		    p->stp_pkt.w_value, p->stp_pkt.w_index, p->stp_pkt.w_length);
 	} else {
-		msg(INF, "usb_jiggler.c: %svnd req=%hhu val=0x%.4hX ind=0x%.4hX len=%hu\n",
-		    (p->stp_pkt.bm_request_type & (1 << 7)) ? ">" : "<",
+		msg(INF, "usb_jiggler.c: " TS_FMT "%svnd req=%hhu val=0x%.4hX ind=0x%.4hX len=%hu\n",
+		    TS_ARGS(p->ts) (p->stp_pkt.bm_request_type & (1 << 7)) ? ">" : "<",
 		    p->stp_pkt.b_request, p->stp_pkt.w_value, p->stp_pkt.w_index,
 		    p->stp_pkt.w_length);
 	}
+#endif
 }
 
+#if USB_LOG_RING == 1
+/**
+ * log_stp_event
+ */
+static void log_stp_event(struct usb_stp_pkt *sp)
+{
+	struct usb_ctl_req_stp_event *e;
+
+	if (!usb_log_on(USB_LOG_M_CTL_REQ_STP)) {
+		return;
+	}
+	if ((e = reserve_usb_log_rec(USB_CTL_REQ_STP_EVENT_TYPE,
+						 sizeof(struct usb_ctl_req_stp_event)))) {
+		e->type = USB_CTL_REQ_STP_EVENT_TYPE;
+#if USB_JIG_LOG_TS == 1
+		e->ts = USB_JIG_TIMESTAMP();
+#endif
+		e->stp_pkt = *sp;
+		e->fmt = fmt_usb_ctl_req_stp_event;
+		commit_usb_log_rec();
+	}
+}
+#else
 static struct usb_ctl_req_stp_event ucrse = {
 	.type = USB_CTL_REQ_STP_EVENT_TYPE,
 	.fmt = fmt_usb_ctl_req_stp_event
@@ -1491,12 +1961,19 @@ static struct usb_ctl_req_stp_event ucrse = {
  */
 static void log_stp_event(struct usb_stp_pkt *sp)
 {
+	if (!usb_log_on(USB_LOG_M_CTL_REQ_STP)) {
+		return;
+	}
+#if USB_JIG_LOG_TS == 1
+	ucrse.ts = USB_JIG_TIMESTAMP();
+#endif
 	ucrse.stp_pkt = *sp;
 	if (pdTRUE != xQueueSendFromISR(usb_logger.que, &ucrse, &dmy)) {
 		usb_logger.que_err();
 	}
 }
 #endif
+#endif
 
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
 /**
@@ -1505,57 +1982,465 @@ static void log_stp_event(struct usb_stp_pkt *sp)
 static void fmt_usb_ctl_req_cmd_event(struct usb_ctl_req_cmd_event *p);
 static void fmt_usb_ctl_req_cmd_event(struct usb_ctl_req_cmd_event *p)
 {
+#if USB_JIG_LOG_TOKENS == 1
+	log_tok(USB_JIG_LOG_MSG_CMD, p->ctl_req_type, (uint8_t) p->ctl_req_code,
+		p->res, TS_TOK(p->ts));
+#else
 	if (p->ctl_req_type == USB_STANDARD_REQUEST) {
-		msg(INF, "usb_jiggler.c: [%s]=%s\n",
+		msg(INF, "usb_jiggler.c: " TS_FMT "[%s]=%s\n", TS_ARGS(p->ts)
 		    find_txt_item(p->ctl_req_code, std_ctl_req_code_str_arry, "undef"),
- 	            p->txt);
+ 	            cmd_res_str[p->res]);
 	} else if (p->ctl_req_type == USB_CLASS_REQUEST) {
-		msg(INF, "usb_jiggler.c: [%s]=%s\n",
+		msg(INF, "usb_jiggler.c: " TS_FMT "[%s]=%s\n", TS_ARGS(p->ts)
 		    find_txt_item(p->ctl_req_code, cls_ctl_req_code_str_arry, "undef"),
- 	            p->txt);
+ 	            cmd_res_str[p->res]);
 	} else {
-		msg(INF, "usb_jiggler.c: %s\n", p->txt);
+		msg(INF, "usb_jiggler.c: " TS_FMT "[vnd_%hhu]=%s\n", TS_ARGS(p->ts)
+		    (uint8_t) p->ctl_req_code, cmd_res_str[p->res]);
 	}
+#endif
 }
 
+#if USB_LOG_RING == 1
+/**
+ * log_cmd_event
+ */
+static void log_cmd_event(int8_t ctl_req_type, enum usb_jig_cmd_res res)
+{
+	struct usb_ctl_req_cmd_event *e;
+
+	if (!usb_log_on(USB_LOG_M_CTL_REQ_CMD)) {
+		return;
+	}
+	if ((e = reserve_usb_log_rec(USB_CTL_REQ_CMD_EVENT_TYPE,
+						 sizeof(struct usb_ctl_req_cmd_event)))) {
+		e->type = USB_CTL_REQ_CMD_EVENT_TYPE;
+		e->ctl_req_type = ctl_req_type;
+		e->ctl_req_code = stp_pkt->b_request;
+#if USB_JIG_LOG_TS == 1
+		e->ts = USB_JIG_TIMESTAMP();
+#endif
+		e->res = res;
+		e->fmt = fmt_usb_ctl_req_cmd_event;
+		commit_usb_log_rec();
+	}
+}
+#else
 static struct usb_ctl_req_cmd_event ucree = {
 	.type = USB_CTL_REQ_CMD_EVENT_TYPE,
 	.fmt = fmt_usb_ctl_req_cmd_event
 };
 
 /**
- * log_std_cmd_event
+ * log_cmd_event
  */
-static void log_std_cmd_event(const char *txt)
+static void log_cmd_event(int8_t ctl_req_type, enum usb_jig_cmd_res res)
 {
-	ucree.ctl_req_type = USB_STANDARD_REQUEST;
+	if (!usb_log_on(USB_LOG_M_CTL_REQ_CMD)) {
+		return;
+	}
+	ucree.ctl_req_type = ctl_req_type;
 	ucree.ctl_req_code = stp_pkt->b_request;
-	ucree.txt = txt;
+#if USB_JIG_LOG_TS == 1
+	ucree.ts = USB_JIG_TIMESTAMP();
+#endif
+	ucree.res = res;
 	if (pdTRUE != xQueueSendFromISR(usb_logger.que, &ucree, &dmy)) {
 		usb_logger.que_err();
 	}
 }
+#endif
+
+/**
+ * log_std_cmd_event
+ */
+static void log_std_cmd_event(enum usb_jig_cmd_res res)
+{
+	log_cmd_event(USB_STANDARD_REQUEST, res);
+}
 
 /**
  * log_cls_cmd_event
  */
-static void log_cls_cmd_event(const char *txt)
+static void log_cls_cmd_event(enum usb_jig_cmd_res res)
 {
-	ucree.ctl_req_type = USB_CLASS_REQUEST;
-	ucree.ctl_req_code = stp_pkt->b_request;
-	ucree.txt = txt;
-	if (pdTRUE != xQueueSendFromISR(usb_logger.que, &ucree, &dmy)) {
-		usb_logger.que_err();
+	log_cmd_event(USB_CLASS_REQUEST, res);
+}
+
+/**
+ * log_vnd_cmd_event
+ */
+static void log_vnd_cmd_event(enum usb_jig_cmd_res res)
+{
+	log_cmd_event((stp_pkt->bm_request_type >> 5) & 3, res);
+}
+#endif
+
+#if USB_JIG_KEYB_IFACE == 1
+/**
+ * add_keyb_report_key
+ */
+boolean_t add_keyb_report_key(struct keyb_report *rep, uint8_t usage)
+{
+#if USB_JIG_KEYB_NKRO == 1
+	if (usage > KEYB_REPORT_USAGE_MAX) {
+		return (FALSE);
+	}
+	rep->bitmap[usage >> 3] |= 1 << (usage & 7);
+	return (TRUE);
+#else
+	int i, free = -1;
+
+	for (i = 0; i < KEYB_REPORT_KEY_ARY_SIZE; i++) {
+		if (rep->keys[i] == usage) {
+			return (TRUE);
+		}
+		if (!rep->keys[i] && free < 0) {
+			free = i;
+		}
 	}
+	if (free < 0) {
+		return (FALSE);
+	}
+	rep->keys[free] = usage;
+	return (TRUE);
+#endif
+}
+
+/**
+ * del_keyb_report_key
+ */
+void del_keyb_report_key(struct keyb_report *rep, uint8_t usage)
+{
+#if USB_JIG_KEYB_NKRO == 1
+	if (usage <= KEYB_REPORT_USAGE_MAX) {
+		rep->bitmap[usage >> 3] &= ~(1 << (usage & 7));
+	}
+#else
+	int i, j;
+
+	for (i = j = 0; i < KEYB_REPORT_KEY_ARY_SIZE; i++) {
+		if (rep->keys[i] != usage) {
+			rep->keys[j++] = rep->keys[i];
+		}
+	}
+	while (j < KEYB_REPORT_KEY_ARY_SIZE) {
+		rep->keys[j++] = 0;
+	}
+#endif
+}
+#endif
+
+#if USB_JIG_KEYB_IFACE == 1 && LOG_KEYB_LEDS == 1
+/**
+ * get_keyb_led_report
+ */
+uint32_t get_keyb_led_report(struct keyb_led_report *rep, uint32_t *seq)
+{
+	uint32_t s, n;
+
+	do {
+		s = led_mbox.seq;
+		mem_barrier();
+		rep->leds = led_mbox.leds;
+		mem_barrier();
+	} while (s != led_mbox.seq);
+	n = s - *seq;
+	*seq = s;
+	return (n);
+}
+
+/**
+ * wait_keyb_led_report
+ */
+uint32_t wait_keyb_led_report(struct keyb_led_report *rep, uint32_t *seq, TickType_t tmo)
+{
+	TimeOut_t to;
+	uint32_t n;
+
+	vTaskSetTimeOutState(&to);
+	// Semaphore may be left given by report already read, check seq first.
+	while (!(n = get_keyb_led_report(rep, seq))) {
+		if (xTaskCheckForTimeOut(&to, &tmo) == pdTRUE || xSemaphoreTake(led_sem, tmo) != pdTRUE) {
+			break;
+		}
+	}
+	return (n);
+}
+#endif
+
+/**
+ * publish_hid_report
+ */
+void publish_hid_report(int iface, const void *rep)
+{
+	struct rep_store *rs;
+	uint32_t seq;
+
+	rs = &rep_stores[iface];
+	seq = rs->seq;
+	rs->seq = seq + 1;
+	mem_barrier();
+	memcpy(rs->slot[((seq >> 1) + 1) & 1], rep, rep_size[iface]);
+#if USB_JIG_STATS_REP == 1
+	stamp_rep_id(iface, rs->slot[((seq >> 1) + 1) & 1]);
+#endif
+	mem_barrier();
+	rs->seq = seq + 2;
+}
+
+/**
+ * read_hid_report
+ */
+void read_hid_report(int iface, void *rep)
+{
+	struct rep_store *rs;
+	uint32_t seq;
+
+	rs = &rep_stores[iface];
+	while (TRUE) {
+		seq = rs->seq;
+		mem_barrier();
+		memcpy(rep, rs->slot[(seq >> 1) & 1], rep_size[iface]);
+		mem_barrier();
+		// Slot is reused by the second write started after seq.
+		if (rs->seq - seq <= ((seq & 1) ? 1 : 2)) {
+			break;
+		}
+	}
+}
+
+/**
+ * reset_idle_rates
+ *
+ * HID idle rates return to defaults on bus reset and SET_CONFIGURATION.
+ */
+static void reset_idle_rates(void)
+{
+	int i;
+
+	for (i = 0; i < HID_IFACE_NMB; i++) {
+		set_idle_rate(i, dflt_idle_rate[i]);
+	}
+}
+
+/**
+ * set_idle_rate
+ *
+ * Called in UDP interrupt or task critical section.
+ */
+static void set_idle_rate(int iface, uint8_t rate)
+{
+	if (idle_rate[iface] != rate) {
+		idle_rate[iface] = rate;
+		idle_chng_tm[iface] = xTaskGetTickCountFromISR();
+		mem_barrier();
+		idle_chng_seq[iface]++;
+	}
+}
+
+/**
+ * is_hid_report_due
+ */
+boolean_t is_hid_report_due(int iface, boolean_t chng)
+{
+	TickType_t tm;
+	uint8_t rate;
+
+	tm = xTaskGetTickCount();
+	if (idle_chng_seen[iface] != idle_chng_seq[iface]) {
+		idle_chng_seen[iface] = idle_chng_seq[iface];
+		mem_barrier();
+		rate = idle_rate[iface];
+		// HID 1.11 7.2.4: report at once if new period already passed since last report
+		// at SET_IDLE, otherwise new period starts at SET_IDLE.
+		if (!rate || idle_chng_tm[iface] - idle_rep_tm[iface] < pdMS_TO_TICKS(4 * rate)) {
+			idle_rep_tm[iface] = idle_chng_tm[iface];
+		}
+	}
+	rate = idle_rate[iface];
+	if (chng || (rate && tm - idle_rep_tm[iface] >= pdMS_TO_TICKS(4 * rate))) {
+		idle_rep_tm[iface] = tm;
+		return (TRUE);
+	}
+	return (FALSE);
+}
+
+#if USB_JIG_HID_SUBMIT == 1
+/**
+ * submit_hid_report
+ */
+boolean_t submit_hid_report(int iface, const void *rep, TickType_t tmo)
+{
+	return (xQueueSend(submit_que[iface], rep, tmo) == pdTRUE);
+}
+
+/**
+ * take_hid_report
+ */
+boolean_t take_hid_report(int iface, void *rep, TickType_t tmo)
+{
+	TimeOut_t to;
+
+	vTaskSetTimeOutState(&to);
+	if (xSemaphoreTake(done_sem[iface], tmo) != pdTRUE) {
+		return (FALSE);
+	}
+	if (xTaskCheckForTimeOut(&to, &tmo) == pdTRUE) {
+		tmo = 0;
+	}
+	if (xQueueReceive(submit_que[iface], rep, tmo) != pdTRUE) {
+		xSemaphoreGive(done_sem[iface]);
+		return (FALSE);
+	}
+#if USB_JIG_STATS_REP == 1
+	stamp_rep_id(iface, rep);
+#endif
+	publish_hid_report(iface, rep);
+	idle_rep_tm[iface] = xTaskGetTickCount();
+	return (TRUE);
+}
+
+/**
+ * complete_hid_report
+ */
+void complete_hid_report(int iface)
+{
+	if (xSemaphoreGive(done_sem[iface]) != pdTRUE) {
+		return;
+	}
+	note_hid_report_sent(iface);
+	if (done_clbk[iface]) {
+		done_clbk[iface](iface, done_clbk_arg[iface]);
+	}
+}
+
+/**
+ * set_hid_report_done_clbk
+ */
+void set_hid_report_done_clbk(int iface, void (*clbk)(int iface, void *arg), void *arg)
+{
+	taskENTER_CRITICAL();
+	done_clbk[iface] = clbk;
+	done_clbk_arg[iface] = arg;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * is_hid_report_in_flight
+ */
+boolean_t is_hid_report_in_flight(int iface)
+{
+	return (uxSemaphoreGetCount(done_sem[iface]) == 0);
+}
+
+/**
+ * get_hid_report_pending
+ */
+int get_hid_report_pending(int iface)
+{
+	return (uxQueueMessagesWaiting(submit_que[iface]));
+}
+#endif
+
+#if USB_JIG_TMLN == 1
+/**
+ * add_tmln_item
+ */
+static void add_tmln_item(enum usb_jig_tmln_evnt evnt)
+{
+	struct usb_jig_tmln_item *p;
+
+	if (tmln_nmb < USB_JIG_TMLN_SIZE) {
+		p = &tmln[tmln_nmb];
+		p->ts = USB_JIG_TIMESTAMP();
+		p->evnt = evnt;
+		if (evnt == USB_JIG_TMLN_BUS_RST) {
+			p->b_request = 0;
+			p->w_value = 0;
+		} else {
+			p->b_request = stp_pkt->b_request;
+			p->w_value = stp_pkt->w_value;
+		}
+		tmln_nmb++;
+	}
+}
+
+/**
+ * get_usb_jiggler_tmln
+ */
+const struct usb_jig_tmln_item *get_usb_jiggler_tmln(int *nmb)
+{
+	*nmb = tmln_nmb;
+	return (tmln);
 }
 #endif
 
 /**
  * get_usb_jiggler_stats
  */
-struct usb_jiggler_stats *get_usb_jiggler_stats(void)
+void get_usb_jiggler_stats(struct usb_jiggler_stats *st)
+{
+	uint32_t gen;
+
+	do {
+		gen = stats_gen;
+		mem_barrier();
+		*st = stats;
+		mem_barrier();
+	} while (gen != stats_gen);
+}
+
+/**
+ * note_hid_report_sent
+ */
+void note_hid_report_sent(int iface)
+{
+	taskENTER_CRITICAL();
+	stats.in_rep_cnt[iface]++;
+	stats_gen++;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * note_usb_jiggler_bus_reset
+ */
+void note_usb_jiggler_bus_reset(void)
+{
+#if USB_JIG_HID_SUBMIT == 1
+	int i;
+#endif
+
+	taskENTER_CRITICAL();
+	stats.bus_rst_cnt++;
+	stats_gen++;
+	bus_rst_ts = USB_JIG_TIMESTAMP();
+	enum_tm_set = FALSE;
+	reset_idle_rates();
+#if USB_JIG_TMLN == 1
+	tmln_nmb = 0;
+	tmln_hid_get_report = FALSE;
+	tmln_hid_set_idle = FALSE;
+	add_tmln_item(USB_JIG_TMLN_BUS_RST);
+#endif
+	taskEXIT_CRITICAL();
+#if USB_JIG_HID_SUBMIT == 1
+	// Endpoint FIFOs are flushed, report in flight is lost.
+	for (i = 0; i < HID_IFACE_NMB; i++) {
+		xSemaphoreGive(done_sem[i]);
+	}
+#endif
+}
+
+/**
+ * note_usb_jiggler_suspend
+ */
+void note_usb_jiggler_suspend(void)
 {
-	return (&stats);
+	taskENTER_CRITICAL();
+	stats.suspend_cnt++;
+	stats_gen++;
+	taskEXIT_CRITICAL();
 }
 
 #if TERMOUT == 1
@@ -1564,11 +2449,60 @@ struct usb_jiggler_stats *get_usb_jiggler_stats(void)
  */
 void log_usb_jiggler_stats(void)
 {
-	if (stats.stp_err_cnt) {
-		msg(INF, "usb_jiggler.c: stp_err=%hu\n", stats.stp_err_cnt);
+	struct usb_jiggler_stats st;
+
+	get_usb_jiggler_stats(&st);
+	if (st.stp_err_cnt) {
+#if USB_JIG_LOG_TOKENS == 1
+		log_tok(USB_JIG_LOG_MSG_STP_ERR, st.stp_err_cnt);
+#else
+		msg(INF, "usb_jiggler.c: stp_err=%lu\n", (unsigned long) st.stp_err_cnt);
+#endif
 	}
-	if (stats.stp_rej_cnt) {
-		msg(INF, "usb_jiggler.c: stp_rej=%hu\n", stats.stp_rej_cnt);
+	if (st.stp_rej_cnt) {
+#if USB_JIG_LOG_TOKENS == 1
+		log_tok(USB_JIG_LOG_MSG_STP_REJ, st.stp_rej_cnt);
+#else
+		msg(INF, "usb_jiggler.c: stp_rej=%lu\n", (unsigned long) st.stp_rej_cnt);
+#endif
 	}
+#if USB_JIG_TMLN == 1
+	log_tmln();
+#endif
 }
+
+#if USB_JIG_TMLN == 1
+/**
+ * log_tmln
+ */
+static void log_tmln(void)
+{
+#if USB_JIG_LOG_TOKENS == 1
+	int i, n;
+
+	n = tmln_nmb;
+	for (i = 0; i < n; i++) {
+		log_tok(USB_JIG_LOG_MSG_TMLN, tmln[i].ts - tmln[0].ts, tmln[i].evnt,
+			tmln[i].b_request, tmln[i].w_value);
+	}
+#else
+	static const char *const evnt_str[] = {
+		[USB_JIG_TMLN_BUS_RST] = "bus_rst",
+		[USB_JIG_TMLN_STD_STP] = "std_stp",
+		[USB_JIG_TMLN_SET_ADDR] = "set_addr_done",
+		[USB_JIG_TMLN_SET_CONF] = "set_conf_done",
+		[USB_JIG_TMLN_HID_GET_REPORT] = "hid_get_report",
+		[USB_JIG_TMLN_HID_SET_IDLE] = "hid_set_idle"
+	};
+	int i, n;
+
+	n = tmln_nmb;
+	for (i = 0; i < n; i++) {
+		msg(INF, "usb_jiggler.c: tmln +%u %s req=%hhu val=0x%.4hX\n",
+		    (unsigned int) (tmln[i].ts - tmln[0].ts), evnt_str[tmln[i].evnt],
+		    tmln[i].b_request, tmln[i].w_value);
+	}
+#endif
+}
+#endif
 #endif
@@ -19,7 +19,132 @@
 #ifndef USB_JIGGLER_H
 #define USB_JIGGLER_H
 
+/*
+ * USB_JIG_DEV_QUAL_DESC
+ *   1 - answer device qualifier and other speed configuration requests as
+ *       if the device was high-speed capable (other speed configuration
+ *       with high-speed encoded polling intervals). Deliberate deviation
+ *       for hosts that retry the stalled requests during enumeration.
+ *   0 - stall them, as USB 2.0 9.6.2 requires from full-speed only device.
+ */
+#ifndef USB_JIG_DEV_QUAL_DESC
+#define USB_JIG_DEV_QUAL_DESC 0
+#endif
+
+/*
+ * USB_JIG_MS_OS_20_DESC
+ *   1 - report USB 2.1 (bcdUSB 0x0210), serve BOS descriptor with MS OS 2.0 platform
+ *       capability and MS OS 2.0 descriptor set (vendor request
+ *       USB_JIG_MS_OS_20_VENDOR_CODE, w_index 7).
+ */
+#ifndef USB_JIG_MS_OS_20_DESC
+#define USB_JIG_MS_OS_20_DESC 0
+#endif
+#ifndef USB_JIG_MS_OS_20_VENDOR_CODE
+#define USB_JIG_MS_OS_20_VENDOR_CODE 0x01
+#endif
+
+/*
+ * USB_JIG_KEYB_NKRO
+ *   1 - keyboard report is modifier byte, reserved byte and bitmap of usages 0 to
+ *       KEYB_REPORT_USAGE_MAX (n-key rollover, 17 bytes, endpoint
+ *       USB_JIG_IN_K_ENDP_MAX_PKT_SIZE must fit it, checked with #error),
+ *   0 - modifier byte, reserved byte and array of 6 keys.
+ */
+#ifndef USB_JIG_KEYB_NKRO
+#define USB_JIG_KEYB_NKRO 0
+#endif
+
+/*
+ * USB_JIG_TMLN
+ *   1 - record enumeration timeline (USB_JIG_TMLN_SIZE items) with
+ *       USB_JIG_TIMESTAMP() time stamps (default tick count, may be
+ *       redefined to cycle counter, e.g. DWT->CYCCNT).
+ */
+#ifndef USB_JIG_TMLN
+#define USB_JIG_TMLN 0
+#endif
+#ifndef USB_JIG_TMLN_SIZE
+#define USB_JIG_TMLN_SIZE 32
+#endif
+#ifndef USB_JIG_TIMESTAMP
+#define USB_JIG_TIMESTAMP() ((uint32_t) xTaskGetTickCountFromISR())
+#endif
+
+/*
+ * USB_JIG_LOG_TS
+ *   1 - setup and command log events are stamped with USB_JIG_TIMESTAMP()
+ *       at capture, log shows time from previous event (+) and time spent
+ *       in log queue (q).
+ */
+#ifndef USB_JIG_LOG_TS
+#define USB_JIG_LOG_TS 0
+#endif
+
+/*
+ * USB_JIG_HID_SUBMIT
+ *   1 - queue interrupt IN reports with submit_hid_report() (up to
+ *       USB_JIG_HID_SUBMIT_QUE_SIZE pending reports per interface).
+ */
+#ifndef USB_JIG_HID_SUBMIT
+#define USB_JIG_HID_SUBMIT 0
+#endif
+#ifndef USB_JIG_HID_SUBMIT_QUE_SIZE
+#define USB_JIG_HID_SUBMIT_QUE_SIZE 4
+#endif
+
+/*
+ * USB_JIG_LOG_TOKENS
+ *   1 - log messages are printed as encoded message id and arguments, host
+ *       renders them with USB_JIG_LOG_MSG_LIST dictionary (sim/logtok).
+ */
+#ifndef USB_JIG_LOG_TOKENS
+#define USB_JIG_LOG_TOKENS 0
+#endif
+
+/*
+ * USB_JIG_LOG_MASK_VENDOR_CODE
+ *   Vendor request (USB_LOG_MASK == 1) setting log mask to w_value
+ *   (bm_request_type 0x40) or returning it (0xC0, 2 bytes).
+ */
+#ifndef USB_JIG_LOG_MASK_VENDOR_CODE
+#define USB_JIG_LOG_MASK_VENDOR_CODE 0x02
+#endif
+
+/*
+ * USB_JIG_STATIC_ALLOC
+ *   1 - queues, queue set, log task and timer of library are allocated
+ *       statically (configSUPPORT_STATIC_ALLOCATION, queue set needs
+ *       FreeRTOS 11 xQueueCreateSetStatic()).
+ */
+#ifndef USB_JIG_STATIC_ALLOC
+#define USB_JIG_STATIC_ALLOC 0
+#endif
+
+/*
+ * USB_JIG_STATS_REP
+ *   1 - mouse interface has vendor defined top level collection with
+ *       feature report USB_JIG_STATS_REP_ID returning struct
+ *       usb_jig_stats_report on GET_REPORT (Feature). Mouse input report
+ *       gets report ID USB_JIG_M_REP_ID (struct mouse_report id, set by
+ *       library).
+ */
+#ifndef USB_JIG_STATS_REP
+#define USB_JIG_STATS_REP 0
+#endif
+
+#define USB_JIG_M_IFACE 0
+#define USB_JIG_K_IFACE 1
+
+#if USB_JIG_STATS_REP == 1
+#define USB_JIG_M_REP_ID 1
+#define USB_JIG_STATS_REP_ID 2
+#endif
+
 struct mouse_report {
+#if USB_JIG_STATS_REP == 1
+	uint8_t id;
+#endif
 	uint8_t bm;
 	int8_t x;
 	int8_t y;
@@ -27,6 +152,20 @@ struct mouse_report {
 } __attribute__ ((__packed__));
 
 #if USB_JIG_KEYB_IFACE == 1
+#if USB_JIG_KEYB_NKRO == 1
+#define KEYB_REPORT_USAGE_MAX 0x77
+#define KEYB_REPORT_BITMAP_SIZE ((KEYB_REPORT_USAGE_MAX + 1) / 8)
+
+struct keyb_report {
+	uint8_t mod;
+	uint8_t res;
+	uint8_t bitmap[KEYB_REPORT_BITMAP_SIZE];
+} __attribute__ ((__packed__));
+
+#if USB_JIG_IN_K_ENDP_MAX_PKT_SIZE < 2 + KEYB_REPORT_BITMAP_SIZE
+#error "USB_JIG_IN_K_ENDP_MAX_PKT_SIZE must fit NKRO keyboard report (17 bytes)"
+#endif
+#else
 #define KEYB_REPORT_KEY_ARY_SIZE 6
 
 struct keyb_report {
@@ -34,41 +173,164 @@ struct keyb_report {
 	uint8_t res;
 	uint8_t keys[KEYB_REPORT_KEY_ARY_SIZE];
 } __attribute__ ((__packed__));
+#endif
 
 struct keyb_led_report {
 	uint8_t leds;
 } __attribute__ ((__packed__));
 #endif
 
+union hid_report {
+	struct mouse_report mouse_report;
+#if USB_JIG_KEYB_IFACE == 1
+	struct keyb_report keyb_report;
+#endif
+};
+
 #define USB_CTL_REQ_STP_EVENT_TYPE 10
 
 struct usb_ctl_req_stp_event {
 	int8_t type;
+#if USB_JIG_LOG_TS == 1
+	uint32_t ts;
+#endif
 	struct usb_stp_pkt stp_pkt;
         void (*fmt)(struct usb_ctl_req_stp_event *);
 };
 
 #define USB_CTL_REQ_CMD_EVENT_TYPE 11
 
+/*
+ * Command event results, tokenized log carries their ids, host tools
+ * render them with this list.
+ */
+#define USB_JIG_CMD_RES_LIST(X)\
+	X(USB_JIG_CMD_RES_DONE, "done")\
+	X(USB_JIG_CMD_RES_REJ, "reject")\
+	X(USB_JIG_CMD_RES_ERR, "error")\
+	X(USB_JIG_CMD_RES_DEV_QUAL_UNSUP, "dev_qual_desc unsupported")\
+	X(USB_JIG_CMD_RES_ALT_SPEED_CONF_UNSUP, "alt_speed_conf_desc unsupported")\
+	X(USB_JIG_CMD_RES_HID_PHYS_UNSUP, "hid_physical_desc unsupported")
+
+#define USB_JIG_CMD_RES_ID(id, txt) id,
+
+enum usb_jig_cmd_res {
+	USB_JIG_CMD_RES_LIST(USB_JIG_CMD_RES_ID)
+	USB_JIG_CMD_RES_NMB
+};
+
 struct usb_ctl_req_cmd_event {
 	int8_t type;
         int8_t ctl_req_type;
 	int8_t ctl_req_code;
-        const char *txt;
+	uint8_t res;
+#if USB_JIG_LOG_TS == 1
+	uint32_t ts;
+#endif
         void (*fmt)(struct usb_ctl_req_cmd_event *);
 };
 
+#if USB_JIG_TMLN == 1
+enum usb_jig_tmln_evnt {
+	USB_JIG_TMLN_BUS_RST,
+	USB_JIG_TMLN_STD_STP,
+	USB_JIG_TMLN_SET_ADDR,
+	USB_JIG_TMLN_SET_CONF,
+	USB_JIG_TMLN_HID_GET_REPORT,
+	USB_JIG_TMLN_HID_SET_IDLE
+};
+
+struct usb_jig_tmln_item {
+	uint32_t ts;
+	uint8_t evnt;
+	uint8_t b_request;
+	uint16_t w_value;
+};
+#endif
+
+enum usb_jig_req_res {
+	USB_JIG_REQ_DONE,
+	USB_JIG_REQ_REJ,
+	USB_JIG_REQ_ERR,
+	USB_JIG_REQ_RES_NMB
+};
+
+/*
+ * Standard request codes 0 - 12, HID class request codes 0 - 11. Last row
+ * of request counters counts codes out of range.
+ */
+#define USB_JIG_STD_REQ_NMB 13
+#define USB_JIG_CLS_REQ_NMB 12
+
 struct usb_jiggler_stats {
-        unsigned short stp_err_cnt;
-	unsigned short stp_rej_cnt;
+	uint32_t stp_err_cnt;
+	uint32_t stp_rej_cnt;
+	uint32_t std_req_cnt[USB_JIG_STD_REQ_NMB + 1][USB_JIG_REQ_RES_NMB];
+	uint32_t cls_req_cnt[USB_JIG_CLS_REQ_NMB + 1][USB_JIG_REQ_RES_NMB];
+	uint32_t vnd_req_cnt[USB_JIG_REQ_RES_NMB];
+	uint32_t in_rep_cnt[USB_JIG_KEYB_IFACE + 1];
+	uint32_t bus_rst_cnt;
+	uint32_t suspend_cnt;
+	uint32_t enum_tm;
 };
 
+#if USB_JIG_STATS_REP == 1
+#define USB_JIG_STATS_REP_VER 2
+
+#if USB_JIG_IN_M_ENDP_MAX_PKT_SIZE < 5
+#error "USB_JIG_IN_M_ENDP_MAX_PKT_SIZE must fit mouse report with report ID (5 bytes)"
+#endif
+
+/*
+ * Feature report, little endian, starts with report ID USB_JIG_STATS_REP_ID.
+ * Times in USB_JIG_TIMESTAMP() units, enum_tm is time from last bus reset
+ * to first non zero SET_CONFIGURATION done. Request counters are totals of
+ * standard, class and vendor requests per outcome.
+ */
+struct usb_jig_stats_report {
+	uint8_t id;
+	uint8_t ver;
+	uint8_t res[2];
+	uint32_t ts;
+	uint32_t enum_tm;
+	uint32_t stp_err_cnt;
+	uint32_t stp_rej_cnt;
+	uint32_t req_cnt[3][USB_JIG_REQ_RES_NMB];
+	uint32_t in_rep_cnt[2];
+	uint32_t bus_rst_cnt;
+	uint32_t suspend_cnt;
+} __attribute__ ((__packed__));
+#endif
+
+#if USB_JIG_LOG_TOKENS == 1
+/*
+ * Tokenized log dictionary. Device prints "usb_jiggler.c: @" and hex bytes
+ * of message id and uint32_t arguments, each number unsigned LEB128 (7 bits
+ * per byte, low first, bit 7 set if more bytes follow). Host renders
+ * arguments with format of message id (order of this list, conversions
+ * %u, %X, %s with optional precision). %s argument is command result id
+ * (USB_JIG_CMD_RES_LIST), q is time spent in log queue (USB_JIG_LOG_TS).
+ * Device uses message ids only, formats are compiled in host tools.
+ */
+#define USB_JIG_LOG_MSG_LIST(X)\
+	X(USB_JIG_LOG_MSG_STP, "stp type=0x%.2X req=%u val=0x%.4X ind=0x%.4X len=%u +%u q%u")\
+	X(USB_JIG_LOG_MSG_CMD, "[type=%u req=%u]=%s +%u q%u")\
+	X(USB_JIG_LOG_MSG_STP_ERR, "stp_err=%u")\
+	X(USB_JIG_LOG_MSG_STP_REJ, "stp_rej=%u")\
+	X(USB_JIG_LOG_MSG_TMLN, "tmln +%u evnt=%u req=%u val=0x%.4X")
+
+#define USB_JIG_LOG_MSG_ID(id, fmt) id,
+#define USB_JIG_LOG_TOK_MAX_ARGS 7
+
+enum usb_jig_log_msg {
+	USB_JIG_LOG_MSG_LIST(USB_JIG_LOG_MSG_ID)
+	USB_JIG_LOG_MSG_NMB
+};
+#endif
+
 extern struct mouse_report mouse_report;
 #if USB_JIG_KEYB_IFACE == 1
 extern struct keyb_report keyb_report;
-#if LOG_KEYB_LEDS == 1
-extern QueueSetHandle_t keyb_led_rep_que;
-#endif
 #endif
 extern QueueSetHandle_t jig_ctl_qset;
 
@@ -79,8 +341,166 @@ void init_usb_jiggler(void);
 
 /**
  * get_usb_jiggler_stats
+ *
+ * Copies consistent snapshot of statistics to st. Copy is retried if
+ * counters were updated meanwhile, interrupts stay enabled. Request
+ * counters and enum_tm are captured by the library. UDP driver events and
+ * endpoint writes are not seen by it: bus_rst_cnt, suspend_cnt and
+ * in_rep_cnt count only application calls of note_usb_jiggler_bus_reset(),
+ * note_usb_jiggler_suspend() and note_hid_report_sent() (complete_hid_report()
+ * with USB_JIG_HID_SUBMIT), enum_tm is measured from the last
+ * note_usb_jiggler_bus_reset() (from start without it).
+ */
+void get_usb_jiggler_stats(struct usb_jiggler_stats *st);
+
+/**
+ * note_hid_report_sent
+ *
+ * Counts report written to interrupt IN endpoint of interface iface.
+ */
+void note_hid_report_sent(int iface);
+
+/**
+ * note_usb_jiggler_bus_reset
+ *
+ * Counts bus reset, restarts enum_tm measurement (time to first non zero
+ * SET_CONFIGURATION) and enumeration timeline (USB_JIG_TMLN). Call on UDP
+ * bus reset state event.
+ */
+void note_usb_jiggler_bus_reset(void);
+
+/**
+ * note_usb_jiggler_suspend
+ *
+ * Counts bus suspend. Call on UDP suspend state event.
+ */
+void note_usb_jiggler_suspend(void);
+
+#if USB_JIG_KEYB_IFACE == 1
+/**
+ * add_keyb_report_key
+ *
+ * Adds key usage to keyboard report. Returns FALSE if report is full.
+ */
+boolean_t add_keyb_report_key(struct keyb_report *rep, uint8_t usage);
+
+/**
+ * del_keyb_report_key
  */
-struct usb_jiggler_stats *get_usb_jiggler_stats(void);
+void del_keyb_report_key(struct keyb_report *rep, uint8_t usage);
+#endif
+
+#if USB_JIG_KEYB_IFACE == 1 && LOG_KEYB_LEDS == 1
+/**
+ * get_keyb_led_report
+ *
+ * Copies latest LED report received from host. Returns number of reports
+ * received since sequence number *seq (more than 1 - intermediate states
+ * were missed) and updates *seq (start with 0).
+ */
+uint32_t get_keyb_led_report(struct keyb_led_report *rep, uint32_t *seq);
+
+/**
+ * wait_keyb_led_report
+ *
+ * Blocking get_keyb_led_report(), waits up to tmo ticks for LED report
+ * newer than *seq. Returns 0 on timeout. One waiting task.
+ */
+uint32_t wait_keyb_led_report(struct keyb_led_report *rep, uint32_t *seq, TickType_t tmo);
+#endif
+
+/**
+ * publish_hid_report
+ *
+ * Publishes report of interface iface for GET_REPORT and read_hid_report().
+ * One writer task per interface. Report ID (USB_JIG_STATS_REP) is set by
+ * library, reports read back and taken are ready to be written to endpoint
+ * as whole struct (sizeof(struct mouse_report) bytes, ID first).
+ */
+void publish_hid_report(int iface, const void *rep);
+
+/**
+ * read_hid_report
+ *
+ * Copies last published report of interface iface (task context).
+ */
+void read_hid_report(int iface, void *rep);
+
+/**
+ * is_hid_report_due
+ *
+ * Interrupt IN report scheduler. Returns TRUE if report of interface iface
+ * (USB_JIG_M_IFACE, USB_JIG_K_IFACE) changed (chng) or idle period set by
+ * host with SET_IDLE expired, and restarts idle period. Changed idle rate
+ * restarts idle period at SET_IDLE, report is due at once if new period
+ * already passed since last report (HID 1.11 7.2.4).
+ */
+boolean_t is_hid_report_due(int iface, boolean_t chng);
+
+#if USB_JIG_HID_SUBMIT == 1
+/**
+ * submit_hid_report
+ *
+ * Queues copy of report of interface iface for sending. Waits up to tmo
+ * ticks for free queue item, returns FALSE on timeout.
+ */
+boolean_t submit_hid_report(int iface, const void *rep, TickType_t tmo);
+
+/**
+ * take_hid_report
+ *
+ * Endpoint writer side. Waits up to tmo ticks in total for completion of
+ * previous report (complete_hid_report()) and for next queued report, marks
+ * it in flight, sets its report ID, publishes it and restarts idle period.
+ * Returns FALSE on timeout. Writer task loop:
+ *   if (take_hid_report(iface, &rep, tmo)) {
+ *           start write of rep to interrupt IN endpoint;
+ *   } else if (is_hid_report_due(iface, FALSE)) {
+ *           read_hid_report(iface, &rep) and write it;
+ *   }
+ * and complete_hid_report(iface) when endpoint write is done. Bus reset
+ * (note_usb_jiggler_bus_reset()) completes report in flight.
+ */
+boolean_t take_hid_report(int iface, void *rep, TickType_t tmo);
+
+/**
+ * complete_hid_report
+ *
+ * Endpoint writer side, task context. Ends in flight state, wakes writer
+ * blocked in take_hid_report() and calls completion callback. Does nothing
+ * if no report is in flight.
+ */
+void complete_hid_report(int iface);
+
+/**
+ * set_hid_report_done_clbk
+ *
+ * Sets completion callback of interface iface (called in writer task
+ * context, e.g. to notify producer task).
+ */
+void set_hid_report_done_clbk(int iface, void (*clbk)(int iface, void *arg), void *arg);
+
+/**
+ * is_hid_report_in_flight
+ *
+ * Returns TRUE between take_hid_report() and complete_hid_report().
+ */
+boolean_t is_hid_report_in_flight(int iface);
+
+/**
+ * get_hid_report_pending
+ *
+ * Returns number of queued reports of interface iface.
+ */
+int get_hid_report_pending(int iface);
+#endif
+
+#if USB_JIG_TMLN == 1
+/**
+ * get_usb_jiggler_tmln
+ */
+const struct usb_jig_tmln_item *get_usb_jiggler_tmln(int *nmb);
+#endif
 
 #if TERMOUT == 1
 /**
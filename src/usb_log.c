@@ -16,27 +16,58 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <string.h>
 #include <FreeRTOS.h>
 #include <task.h>
 #include <semphr.h>
 #include <queue.h>
+#include <timers.h>
 #include <gentyp.h>
 #include "sysconf.h"
 #include "msgconf.h"
 #include "criterr.h"
 #include "udp.h"
 #include "usb_ctl_req.h"
-#include "usb_cdc_def.h"
 #include "usb_jiggler.h"
 #include "usb_log.h"
 
+#if USB_LOG_MASK == 1
+volatile uint32_t usb_log_mask = USB_LOG_M_ALL;
+
+/**
+ * set_usb_log_mask
+ */
+void set_usb_log_mask(uint32_t mask)
+{
+	usb_log_mask = mask;
+}
+#endif
+
 #if UDP_LOG_INTR_EVENTS == 1 || UDP_LOG_STATE_EVENTS == 1 ||\
     UDP_LOG_ENDP_EVENTS == 1 || UDP_LOG_OUT_IRP_EVENTS == 1 ||\
     UDP_LOG_ERR_EVENTS == 1 || USB_LOG_CTL_REQ_EVENTS == 1 ||\
     USB_LOG_CTL_REQ_STP_EVENTS == 1 || USB_LOG_CTL_REQ_CMD_EVENTS == 1
 
+#if USB_LOG_DRAIN != USB_LOG_DRAIN_TASK && (!defined(MSG_NONBLOCK) || MSG_NONBLOCK != 1)
+#error "USB_LOG_DRAIN_IDLE and USB_LOG_DRAIN_TMR need msg() which never blocks (MSG_NONBLOCK 1)"
+#endif
+
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
 static TaskHandle_t hndl;
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticTask_t tsk_stc;
+static StackType_t tsk_stack[USB_LOG_EVENTS_TASK_STACK_SIZE];
+#endif
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_TMR
+static TimerHandle_t drain_tmr;
+static volatile boolean_t drain_pend;
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticTimer_t drain_tmr_stc;
+#endif
+#endif
+#if USB_LOG_DRAIN != USB_LOG_DRAIN_IDLE
 static const char *nm = "USBLOG";
+#endif
 
 static union log_entry {
 	int8_t type;
@@ -48,28 +79,125 @@ static union log_entry {
         struct usb_ctl_req_event usb_ctl_req_event;
 	struct usb_ctl_req_stp_event usb_ctl_req_stp_event;
 	struct usb_ctl_req_cmd_event usb_ctl_req_cmd_event;
+#if USB_LOG_RING == 1
+	struct usb_log_gap_event usb_log_gap_event;
+#endif
 } log_entry;
 
+#if USB_LOG_RING == 1
+/*
+ * Logger queue item, library events go through ring.
+ */
+union que_entry {
+	int8_t type;
+	struct udp_intr_event udp_intr_event;
+	struct udp_state_event udp_state_event;
+        struct udp_endp_event udp_endp_event;
+	struct udp_out_irp_event udp_out_irp_event;
+        struct udp_err_event udp_err_event;
+        struct usb_ctl_req_event usb_ctl_req_event;
+};
+
+#define QUE_LEN USB_LOG_RING_QUEUE_SIZE
+#define QUE_ITEM_SIZE sizeof(union que_entry)
+#else
+#define QUE_LEN USB_LOG_EVENTS_QUEUE_SIZE
+#define QUE_ITEM_SIZE sizeof(union log_entry)
+#endif
+
+#if USB_JIG_STATIC_ALLOC == 1
+static StaticQueue_t que_stc;
+static uint8_t que_buf[QUE_LEN * QUE_ITEM_SIZE];
+#endif
 static logger_t usb_logger;
 static unsigned int qfull_cnt;
 
+#if USB_LOG_RING == 1
+#define RING_REC_HDR_SIZE sizeof(uint32_t)
+#define RING_WRAP_REC 0
+// Drop counters of event types 0 to DROP_TYPE_NMB - 1 and others.
+#define DROP_TYPE_NMB 16
+
+#define mem_barrier() __asm__ __volatile__ ("" ::: "memory")
+
+#if (USB_LOG_RING_SIZE & (USB_LOG_RING_SIZE - 1)) != 0
+#error "USB_LOG_RING_SIZE must be power of 2"
+#endif
+
+/*
+ * Records are 4 byte size header (RING_WRAP_REC - rest of ring up to end is
+ * unused) and event, rounded up to 4 bytes. Head and tail are free running
+ * byte counters, head is written by producer only, tail by log task only.
+ * Ring is array of words, ring_at() returns word at byte offset pos.
+ */
+#define ring_at(pos) (&ring[(pos) / sizeof(uint32_t)])
+
+static uint32_t ring[USB_LOG_RING_SIZE / sizeof(uint32_t)];
+static volatile uint32_t ring_head, ring_tail;
+static uint32_t ring_rsv_head;
+static volatile uint16_t ring_lost;
+static unsigned int drop_cnt[DROP_TYPE_NMB + 1];
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
+static const union que_entry wake_evnt = {.type = USB_LOG_WAKE_EVENT_TYPE};
+static volatile boolean_t ring_wake;
+#endif
+
+static void *alloc_rec(uint32_t h, int size);
+static void count_drop(int8_t type);
+static int drain_ring(int max);
+#endif
+
 static void inc_qfull_cnt(void);
+#if USB_LOG_DRAIN != USB_LOG_DRAIN_TASK || USB_LOG_RING == 1
+static int drain_log(int max);
+#endif
+static void fmt_log_entry(union log_entry *e);
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
 static void tsk(void *p);
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_TMR
+static void drain_tmr_clbk(TimerHandle_t tmr);
+static void pend_drain(void *p, uint32_t u);
+#endif
 
 /**
  * init_usb_log
  */
 logger_t *init_usb_log(void)
 {
-        usb_logger.que = xQueueCreate(USB_LOG_EVENTS_QUEUE_SIZE, sizeof(union log_entry));
+#if USB_JIG_STATIC_ALLOC == 1
+	usb_logger.que = xQueueCreateStatic(QUE_LEN, QUE_ITEM_SIZE, que_buf, &que_stc);
+#else
+        usb_logger.que = xQueueCreate(QUE_LEN, QUE_ITEM_SIZE);
         if (usb_logger.que == NULL) {
                 crit_err_exit(MALLOC_ERROR);
         }
+#endif
 	usb_logger.que_err = inc_qfull_cnt;
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
+#if USB_JIG_STATIC_ALLOC == 1
+	hndl = xTaskCreateStatic(tsk, nm, USB_LOG_EVENTS_TASK_STACK_SIZE, NULL,
+				 USB_LOG_EVENTS_TASK_PRIO, tsk_stack, &tsk_stc);
+#else
         if (pdPASS != xTaskCreate(tsk, nm, USB_LOG_EVENTS_TASK_STACK_SIZE, NULL,
 				  USB_LOG_EVENTS_TASK_PRIO, &hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
+#endif
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_TMR
+#if USB_JIG_STATIC_ALLOC == 1
+	drain_tmr = xTimerCreateStatic(nm, pdMS_TO_TICKS(USB_LOG_DRAIN_MS), pdTRUE, NULL,
+				       drain_tmr_clbk, &drain_tmr_stc);
+#else
+	drain_tmr = xTimerCreate(nm, pdMS_TO_TICKS(USB_LOG_DRAIN_MS), pdTRUE, NULL, drain_tmr_clbk);
+	if (drain_tmr == NULL) {
+                crit_err_exit(MALLOC_ERROR);
+	}
+#endif
+	// Start command goes through timer queue, it can fail in both modes.
+	if (pdPASS != xTimerStart(drain_tmr, 0)) {
+                crit_err_exit(MALLOC_ERROR);
+	}
+#endif
 	return (&usb_logger);
 }
 
@@ -78,11 +206,203 @@ logger_t *init_usb_log(void)
  */
 void log_usb_log_stats(void)
 {
+#if USB_LOG_RING == 1
+	int i;
+#endif
+
 	if (qfull_cnt) {
 		msg(INF, "usb_log.c: log_usb_que_full=%u\n", qfull_cnt);
 	}
+#if USB_LOG_RING == 1
+	for (i = 0; i <= DROP_TYPE_NMB; i++) {
+		if (drop_cnt[i]) {
+			msg(INF, "usb_log.c: log_drop[%d]=%u\n", (i < DROP_TYPE_NMB) ? i : -1, drop_cnt[i]);
+		}
+	}
+#endif
+}
+
+#if USB_LOG_RING == 1
+/**
+ * reserve_usb_log_rec
+ */
+void *reserve_usb_log_rec(int8_t type, int size)
+{
+	void *p;
+	uint32_t h;
+#if USB_LOG_RING_OVERWRITE == 0
+	struct usb_log_gap_event *g = NULL;
+
+	h = ring_head;
+	if (ring_lost) {
+		// Gap marker goes before next stored record, both or none.
+		if ((g = alloc_rec(h, sizeof(struct usb_log_gap_event)))) {
+			g->type = USB_LOG_GAP_EVENT_TYPE;
+			g->cnt = ring_lost;
+			h = ring_rsv_head;
+		}
+	}
+	if (ring_lost && !g) {
+		p = NULL;
+	} else if ((p = alloc_rec(h, size)) && g) {
+		ring_lost = 0;
+	}
+#else
+	h = ring_head;
+	p = alloc_rec(h, size);
+#endif
+	if (!p) {
+		count_drop(type);
+	}
+	return (p);
 }
 
+/**
+ * commit_usb_log_rec
+ */
+void commit_usb_log_rec(void)
+{
+	mem_barrier();
+	ring_head = ring_rsv_head;
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
+	if (!ring_wake) {
+		ring_wake = TRUE;
+		if (pdTRUE != xQueueSendFromISR(usb_logger.que, &wake_evnt, NULL)) {
+			// Full queue wakes log task as well, it drains ring after every event.
+			ring_wake = FALSE;
+		}
+	}
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_TMR
+	if (!drain_pend) {
+		drain_pend = TRUE;
+		xTimerPendFunctionCallFromISR(pend_drain, NULL, 0, NULL);
+	}
+#endif
+}
+
+/**
+ * alloc_rec
+ */
+static void *alloc_rec(uint32_t h, int size)
+{
+	uint32_t n, pos, skip;
+#if USB_LOG_RING_OVERWRITE == 1
+	uint32_t t, m;
+
+	if (size > (int) sizeof(union log_entry)) {
+		return (NULL);
+	}
+#endif
+	n = (RING_REC_HDR_SIZE + size + 3) & ~3;
+	pos = h & (USB_LOG_RING_SIZE - 1);
+	// Record is never split, rest of ring is skipped.
+	skip = (USB_LOG_RING_SIZE - pos < n) ? USB_LOG_RING_SIZE - pos : 0;
+	while (USB_LOG_RING_SIZE - (h - ring_tail) < skip + n) {
+#if USB_LOG_RING_OVERWRITE == 1
+		// Log task is not inside ring (critical section), discard oldest.
+		if ((t = ring_tail) == h) {
+			return (NULL);
+		}
+		pos = t & (USB_LOG_RING_SIZE - 1);
+		if ((m = *ring_at(pos)) == RING_WRAP_REC) {
+			t += USB_LOG_RING_SIZE - pos;
+		} else {
+			count_drop(*(int8_t *) ring_at(pos + RING_REC_HDR_SIZE));
+			t += m;
+		}
+		ring_tail = t;
+		pos = h & (USB_LOG_RING_SIZE - 1);
+#else
+		return (NULL);
+#endif
+	}
+	if (skip) {
+		*ring_at(pos) = RING_WRAP_REC;
+		h += skip;
+		pos = 0;
+	}
+	*ring_at(pos) = n;
+	ring_rsv_head = h + n;
+	return (ring_at(pos + RING_REC_HDR_SIZE));
+}
+
+/**
+ * count_drop
+ */
+static void count_drop(int8_t type)
+{
+	drop_cnt[((uint8_t) type < DROP_TYPE_NMB) ? (uint8_t) type : DROP_TYPE_NMB]++;
+	if (ring_lost < UINT16_MAX) {
+		ring_lost++;
+	}
+}
+
+#if USB_LOG_RING_OVERWRITE == 1
+/**
+ * drain_ring
+ */
+static int drain_ring(int max)
+{
+	uint32_t t, n, pos;
+	boolean_t rec;
+	int cnt = 0;
+
+	do {
+		rec = FALSE;
+		taskENTER_CRITICAL();
+		if (ring_lost) {
+			log_entry.usb_log_gap_event.type = USB_LOG_GAP_EVENT_TYPE;
+			log_entry.usb_log_gap_event.cnt = ring_lost;
+			ring_lost = 0;
+			rec = TRUE;
+		}
+		for (t = ring_tail; !rec && t != ring_head; ring_tail = t) {
+			pos = t & (USB_LOG_RING_SIZE - 1);
+			if ((n = *ring_at(pos)) == RING_WRAP_REC) {
+				t += USB_LOG_RING_SIZE - pos;
+			} else {
+				memcpy(&log_entry, ring_at(pos + RING_REC_HDR_SIZE), n - RING_REC_HDR_SIZE);
+				t += n;
+				rec = TRUE;
+			}
+		}
+		taskEXIT_CRITICAL();
+		if (rec) {
+			fmt_log_entry(&log_entry);
+			cnt++;
+		}
+	} while (rec && cnt < max);
+	return (cnt);
+}
+#else
+/**
+ * drain_ring
+ */
+static int drain_ring(int max)
+{
+	uint32_t h, t, n, pos;
+	int cnt = 0;
+
+	h = ring_head;
+	mem_barrier();
+	for (t = ring_tail; t != h && cnt < max; ring_tail = t) {
+		pos = t & (USB_LOG_RING_SIZE - 1);
+		if ((n = *ring_at(pos)) == RING_WRAP_REC) {
+			t += USB_LOG_RING_SIZE - pos;
+		} else {
+			// Copy, record is only word aligned.
+			memcpy(&log_entry, ring_at(pos + RING_REC_HDR_SIZE), n - RING_REC_HDR_SIZE);
+			fmt_log_entry(&log_entry);
+			t += n;
+			cnt++;
+		}
+		mem_barrier();
+	}
+	return (cnt);
+}
+#endif
+#endif
+
 /**
  * inc_qfull_cnt
  */
@@ -91,6 +411,28 @@ static void inc_qfull_cnt(void)
 	qfull_cnt++;
 }
 
+#if USB_LOG_DRAIN != USB_LOG_DRAIN_TASK || USB_LOG_RING == 1
+/**
+ * drain_log
+ *
+ * Formats up to max waiting events, returns number of formatted events.
+ */
+static int drain_log(int max)
+{
+	int cnt = 0;
+
+#if USB_LOG_RING == 1
+	cnt = drain_ring(max);
+#endif
+	while (cnt < max && pdTRUE == xQueueReceive(usb_logger.que, &log_entry, 0)) {
+		fmt_log_entry(&log_entry);
+		cnt++;
+	}
+	return (cnt);
+}
+#endif
+
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
 /**
  * tsk
  */
@@ -98,51 +440,119 @@ static void tsk(void *p)
 {
 	while (TRUE) {
 		xQueueReceive(usb_logger.que, &log_entry, portMAX_DELAY);
-		switch (log_entry.type) {
+		fmt_log_entry(&log_entry);
+#if USB_LOG_RING == 1
+		while (drain_log(USB_LOG_DRAIN_BATCH)) {
+			;
+		}
+#endif
+	}
+}
+#elif USB_LOG_DRAIN == USB_LOG_DRAIN_IDLE
+/**
+ * run_usb_log_drain
+ */
+void run_usb_log_drain(void)
+{
+	drain_log(USB_LOG_DRAIN_BATCH);
+}
+#else
+/**
+ * drain_tmr_clbk
+ */
+static void drain_tmr_clbk(TimerHandle_t tmr)
+{
+	pend_drain(NULL, 0);
+}
+
+/**
+ * pend_drain
+ */
+static void pend_drain(void *p, uint32_t u)
+{
+	drain_pend = FALSE;
+	if (drain_log(USB_LOG_DRAIN_BATCH) == USB_LOG_DRAIN_BATCH && !drain_pend) {
+		// More events may wait, continue in next pass.
+		drain_pend = TRUE;
+		if (pdPASS != xTimerPendFunctionCall(pend_drain, NULL, 0, 0)) {
+			drain_pend = FALSE;
+		}
+	}
+}
+#endif
+
+/**
+ * fmt_log_entry
+ */
+static void fmt_log_entry(union log_entry *e)
+{
+	switch (e->type) {
 #if UDP_LOG_INTR_EVENTS == 1
-		case UDP_INTR_EVENT_TYPE :
-			(*log_entry.udp_intr_event.fmt)(&log_entry.udp_intr_event);
-			break;
+	case UDP_INTR_EVENT_TYPE :
+		if (usb_log_on(USB_LOG_M_UDP_INTR)) {
+			(*e->udp_intr_event.fmt)(&e->udp_intr_event);
+		}
+		break;
 #endif
 #if UDP_LOG_STATE_EVENTS == 1
-		case UDP_STATE_EVENT_TYPE :
-			(*log_entry.udp_state_event.fmt)(&log_entry.udp_state_event);
-			break;
+	case UDP_STATE_EVENT_TYPE :
+		if (usb_log_on(USB_LOG_M_UDP_STATE)) {
+			(*e->udp_state_event.fmt)(&e->udp_state_event);
+		}
+		break;
 #endif
 #if UDP_LOG_ENDP_EVENTS == 1
-		case UDP_ENDP_EVENT_TYPE :
-			(*log_entry.udp_endp_event.fmt)(&log_entry.udp_endp_event);
-			break;
+	case UDP_ENDP_EVENT_TYPE :
+		if (usb_log_on(USB_LOG_M_UDP_ENDP)) {
+			(*e->udp_endp_event.fmt)(&e->udp_endp_event);
+		}
+		break;
 #endif
 #if UDP_LOG_OUT_IRP_EVENTS == 1
-		case UDP_OUT_IRP_EVENT_TYPE :
-			(*log_entry.udp_out_irp_event.fmt)(&log_entry.udp_out_irp_event);
-			break;
+	case UDP_OUT_IRP_EVENT_TYPE :
+		if (usb_log_on(USB_LOG_M_UDP_OUT_IRP)) {
+			(*e->udp_out_irp_event.fmt)(&e->udp_out_irp_event);
+		}
+		break;
 #endif
 #if UDP_LOG_ERR_EVENTS == 1
-		case UDP_ERR_EVENT_TYPE :
-			(*log_entry.udp_err_event.fmt)(&log_entry.udp_err_event);
-			break;
+	case UDP_ERR_EVENT_TYPE :
+		if (usb_log_on(USB_LOG_M_UDP_ERR)) {
+			(*e->udp_err_event.fmt)(&e->udp_err_event);
+		}
+		break;
 #endif
 #if USB_LOG_CTL_REQ_EVENTS == 1
-		case USB_CTL_REQ_EVENT_TYPE :
-			(*log_entry.usb_ctl_req_event.fmt)(&log_entry.usb_ctl_req_event);
-			break;
+	case USB_CTL_REQ_EVENT_TYPE :
+		if (usb_log_on(USB_LOG_M_CTL_REQ)) {
+			(*e->usb_ctl_req_event.fmt)(&e->usb_ctl_req_event);
+		}
+		break;
 #endif
 #if USB_LOG_CTL_REQ_STP_EVENTS == 1
-		case USB_CTL_REQ_STP_EVENT_TYPE :
-			(*log_entry.usb_ctl_req_stp_event.fmt)(&log_entry.usb_ctl_req_stp_event);
-			break;
+	case USB_CTL_REQ_STP_EVENT_TYPE :
+		(*e->usb_ctl_req_stp_event.fmt)(&e->usb_ctl_req_stp_event);
+		break;
 #endif
 #if USB_LOG_CTL_REQ_CMD_EVENTS == 1
-		case USB_CTL_REQ_CMD_EVENT_TYPE :
-			(*log_entry.usb_ctl_req_cmd_event.fmt)(&log_entry.usb_ctl_req_cmd_event);
-			break;
+	case USB_CTL_REQ_CMD_EVENT_TYPE :
+		(*e->usb_ctl_req_cmd_event.fmt)(&e->usb_ctl_req_cmd_event);
+		break;
 #endif
-		default :
-			msg(INF, "usb_log.c: unknown log event\n");
-			break;
-		}
+#if USB_LOG_RING == 1
+	case USB_LOG_GAP_EVENT_TYPE :
+		msg(INF, "usb_log.c: --- %hu events lost ---\n", e->usb_log_gap_event.cnt);
+		break;
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_TASK
+	case USB_LOG_WAKE_EVENT_TYPE :
+		// Ring is drained next, following commit posts new wake event.
+		ring_wake = FALSE;
+		break;
+#endif
+#endif
+	default :
+		msg(INF, "usb_log.c: unknown log event\n");
+		break;
 	}
 }
 #endif
@@ -19,6 +19,108 @@
 #ifndef USB_LOG_H
 #define USB_LOG_H
 
+/*
+ * USB_LOG_RING
+ *   1 - library events are written in place into USB_LOG_RING_SIZE bytes
+ *       (power of 2) ring of variable length records (single producer -
+ *       USB interrupt). Logger queue carries UDP driver and control request
+ *       layer events only, its length is USB_LOG_RING_QUEUE_SIZE instead of
+ *       USB_LOG_EVENTS_QUEUE_SIZE. Log task blocks on logger queue, first
+ *       ring commit after it took wake event (USB_LOG_WAKE_EVENT_TYPE) posts
+ *       next one.
+ */
+#ifndef USB_LOG_RING
+#define USB_LOG_RING 0
+#endif
+#ifndef USB_LOG_RING_SIZE
+#define USB_LOG_RING_SIZE 512
+#endif
+#ifndef USB_LOG_RING_QUEUE_SIZE
+#define USB_LOG_RING_QUEUE_SIZE 16
+#endif
+
+/*
+ * USB_LOG_RING_OVERWRITE
+ *   1 - full ring discards oldest records (log task copies records out of
+ *       ring in short critical section),
+ *   0 - full ring drops new records.
+ * Lost records are counted per event type and reported in log by gap
+ * marker event.
+ */
+#ifndef USB_LOG_RING_OVERWRITE
+#define USB_LOG_RING_OVERWRITE 0
+#endif
+
+/*
+ * USB_LOG_DRAIN
+ *   USB_LOG_DRAIN_TASK - log is formatted by USBLOG task,
+ *   USB_LOG_DRAIN_IDLE - by run_usb_log_drain() called from application
+ *                        idle hook,
+ *   USB_LOG_DRAIN_TMR - by timer service task every USB_LOG_DRAIN_MS and
+ *                       after ring commit.
+ *   Idle and timer modes format at most USB_LOG_DRAIN_BATCH events per pass
+ *   and need no task stack. Neither idle hook nor timer service task may
+ *   block, application msgconf.h has to declare msg() (used by library and
+ *   UDP driver formatters) which never blocks, e.g. drops output when its
+ *   buffer is full, by MSG_NONBLOCK 1. Build fails otherwise.
+ */
+#define USB_LOG_DRAIN_TASK 0
+#define USB_LOG_DRAIN_IDLE 1
+#define USB_LOG_DRAIN_TMR 2
+
+#ifndef USB_LOG_DRAIN
+#define USB_LOG_DRAIN USB_LOG_DRAIN_TASK
+#endif
+#ifndef USB_LOG_DRAIN_BATCH
+#define USB_LOG_DRAIN_BATCH 8
+#endif
+#ifndef USB_LOG_DRAIN_MS
+#define USB_LOG_DRAIN_MS 20
+#endif
+
+#define USB_LOG_GAP_EVENT_TYPE 12
+#define USB_LOG_WAKE_EVENT_TYPE 13
+
+struct usb_log_gap_event {
+	int8_t type;
+	uint16_t cnt;
+};
+
+/*
+ * USB_LOG_MASK
+ *   1 - compiled in log categories can be switched at runtime with
+ *       usb_log_mask bits (set_usb_log_mask(), vendor request
+ *       USB_JIG_LOG_MASK_VENDOR_CODE). Library events are dropped before
+ *       they are captured, UDP driver and control request layer events
+ *       before they are formatted.
+ */
+#ifndef USB_LOG_MASK
+#define USB_LOG_MASK 0
+#endif
+
+#define USB_LOG_M_UDP_INTR (1 << 0)
+#define USB_LOG_M_UDP_STATE (1 << 1)
+#define USB_LOG_M_UDP_ENDP (1 << 2)
+#define USB_LOG_M_UDP_OUT_IRP (1 << 3)
+#define USB_LOG_M_UDP_ERR (1 << 4)
+#define USB_LOG_M_CTL_REQ (1 << 5)
+#define USB_LOG_M_CTL_REQ_STP (1 << 6)
+#define USB_LOG_M_CTL_REQ_CMD (1 << 7)
+#define USB_LOG_M_ALL 0xFF
+
+#if USB_LOG_MASK == 1
+extern volatile uint32_t usb_log_mask;
+
+#define usb_log_on(m) (usb_log_mask & (m))
+
+/**
+ * set_usb_log_mask
+ */
+void set_usb_log_mask(uint32_t mask);
+#else
+#define usb_log_on(m) 1
+#endif
+
 #if UDP_LOG_INTR_EVENTS == 1 || UDP_LOG_STATE_EVENTS == 1 ||\
     UDP_LOG_ENDP_EVENTS == 1 || UDP_LOG_OUT_IRP_EVENTS == 1 ||\
     UDP_LOG_ERR_EVENTS == 1 || USB_LOG_CTL_REQ_EVENTS == 1 ||\
@@ -33,6 +135,32 @@ logger_t *init_usb_log(void);
  * log_usb_log_stats
  */
 void log_usb_log_stats(void);
+
+#if USB_LOG_DRAIN == USB_LOG_DRAIN_IDLE
+/**
+ * run_usb_log_drain
+ *
+ * Formats up to USB_LOG_DRAIN_BATCH log events, call from
+ * vApplicationIdleHook().
+ */
+void run_usb_log_drain(void);
+#endif
+
+#if USB_LOG_RING == 1
+/**
+ * reserve_usb_log_rec
+ *
+ * Reserves record of size bytes (event struct starting with type) in log
+ * ring. Returns NULL if ring is full and record is dropped. Record is 4 byte
+ * aligned and passed to log task by commit_usb_log_rec().
+ */
+void *reserve_usb_log_rec(int8_t type, int size);
+
+/**
+ * commit_usb_log_rec
+ */
+void commit_usb_log_rec(void);
+#endif
 #endif
 
 #endif